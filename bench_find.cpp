@@ -0,0 +1,180 @@
+//
+//  bench_find.cpp
+//  StaticMap
+//
+
+#include "bench_find.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "refmap.hpp"
+#include "unimap.hpp"
+
+// the slots of the map that searches its tree, which has no storage
+struct NoSlot
+{
+};
+
+template<typename TStorage, typename TSlot>
+static TStorage storageOf(std::vector<TSlot>& slots)
+{
+    return TStorage(slots.data(), slots.size());
+}
+
+template<typename TStorage>
+static TStorage storageOf(std::vector<NoSlot>&)
+{
+    return TStorage();
+}
+
+// times lookups of random keys in a map of count items, one findKey at a
+// time against findKeys a message of keys at a time.  half of the keys are
+// not in the map.  the items are made on the heap here only because the
+// counts are too big to declare, and are in random order in memory like
+// static items whose keys do not follow their declarations.
+template<template<typename, typename, typename, typename> class TLookup, typename TSlot>
+static void timeFind(const char* name, int count, size_t slotCount)
+{
+    typedef static_map::UniMap<int, int, std::less<int>, TLookup> BMap;
+    typedef typename BMap::Item BItem;
+    typedef typename BMap::Builder BBuilder;
+    typedef typename BMap::TIndexStorage BStorage;
+
+    std::vector<int> keys(count);
+    for (int i = 0; i < count; ++i)
+    {
+        keys[i] = 2 * i;
+    }
+    std::mt19937 gen(count);
+    std::shuffle(keys.begin(), keys.end(), gen);
+
+    BBuilder builder;
+    std::deque<BItem> items;
+    for (int i = 0; i < count; ++i)
+    {
+        items.emplace_back(builder, keys[i], i);
+    }
+    std::vector<TSlot> slots(slotCount);
+    std::unique_ptr<BMap> map(new BMap(builder, storageOf<BStorage>(slots)));
+
+    const size_t lookups = 1000000;
+    const size_t message = 256;
+    std::uniform_int_distribution<int> pick(0, 2 * count - 1);
+    std::vector<int> wanted(lookups);
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        wanted[i] = pick(gen);
+    }
+    std::vector<const BItem*> found(lookups);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        found[i] = map->findKey(wanted[i]);
+    }
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+    const double singleTime = std::chrono::duration<double, std::milli>(stop - start).count();
+    std::vector<const BItem*> singles(found);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i += message)
+    {
+        map->findKeys(&wanted[i], std::min(message, lookups - i), &found[i]);
+    }
+    stop = std::chrono::steady_clock::now();
+    const double batchTime = std::chrono::duration<double, std::milli>(stop - start).count();
+
+    // make sure the results are the same
+    if (found != singles)
+    {
+        std::cout << "bad batch of " << name << " " << count << std::endl;
+    }
+    std::cout << name << " items=" << count << " lookups=" << lookups << " findKey=" << singleTime
+              << "ms findKeys=" << batchTime << "ms" << std::endl;
+}
+
+// the data of the RefMap, which is apart from its item in memory
+struct BRecord
+{
+    int m_key;
+    int m_val;
+    const int& key() const { return m_key; }
+};
+
+// times single findKey calls on a RefMap of count items, where each level
+// of the tree search has to go from the item to the data for the key unless
+// the items keep the keys themselves (see STATIC_MAP_KEY_CACHE)
+static void timeRefFind(int count)
+{
+    typedef static_map::RefMap<BRecord, int> BMap;
+    typedef BMap::Item BItem;
+    typedef BMap::Builder BBuilder;
+
+    std::vector<BRecord> records(count);
+    for (int i = 0; i < count; ++i)
+    {
+        records[i].m_key = 2 * i;
+        records[i].m_val = i;
+    }
+    std::mt19937 gen(count);
+    std::shuffle(records.begin(), records.end(), gen);
+
+    BBuilder builder;
+    std::deque<BItem> items;
+    for (int i = 0; i < count; ++i)
+    {
+        items.emplace_back(builder, records[i]);
+    }
+    std::unique_ptr<BMap> map(new BMap(builder));
+
+    const size_t lookups = 1000000;
+    std::uniform_int_distribution<int> pick(0, count - 1);
+    std::vector<int> wanted(lookups);
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        wanted[i] = 2 * pick(gen);
+    }
+
+    long long sum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        const BRecord* record = map->findKey(wanted[i]);
+        sum += record ? record->m_val : -1;
+    }
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+    const double time = std::chrono::duration<double, std::milli>(stop - start).count();
+
+    // make sure the result is used
+    if (sum < 0)
+    {
+        std::cout << "bad refmap of " << count << std::endl;
+    }
+    std::cout << "refmap items=" << count << " lookups=" << lookups << " keycache=" << STATIC_MAP_KEY_CACHE
+              << " findKey=" << time << "ms" << std::endl;
+}
+
+void benchFind()
+{
+    typedef static_map::UniMap<int, int, std::less<int>, static_map::EytzingerIndex>::TIndex EIndex;
+    typedef static_map::UniMap<int, int, std::less<int>, static_map::STreeIndex>::TIndex SIndex;
+    typedef static_map::UniMap<int, int, std::less<int>, static_map::PerfectHashIndex>::TIndex PIndex;
+
+    std::cout << "Start Bench Find" << std::endl;
+    const int counts[] = {10000, 1000000};
+    for (int count : counts)
+    {
+        timeFind<static_map::TreeIndex, NoSlot>("tree", count, 0);
+        timeFind<static_map::EytzingerIndex, EIndex::Slot>("eytzinger", count, count);
+        timeFind<static_map::STreeIndex, SIndex::Block>("stree", count, SIndex::blocksFor(count));
+        timeFind<static_map::PerfectHashIndex, PIndex::Slot>("perfecthash", count, PIndex::slotsFor(count));
+        timeRefFind(count);
+    }
+    std::cout << "Stop Bench" << std::endl;
+}
@@ -0,0 +1,11 @@
+//
+//  bench_find.hpp
+//  StaticMap
+//
+
+#ifndef bench_find_hpp
+#define bench_find_hpp
+
+void benchFind();
+
+#endif /* bench_find_hpp */
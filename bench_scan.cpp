@@ -0,0 +1,98 @@
+//
+//  bench_scan.cpp
+//  StaticMap
+//
+
+#include "bench_scan.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "unimap.hpp"
+
+typedef static_map::UniMap<int, int, std::less<int>> BMap;
+typedef BMap::Item BItem;
+typedef BMap::Builder BBuilder;
+
+// times a full scan of a map of count items through its sequence, next to a
+// walk of a plain array holding the same values.  each is repeated so that
+// the times are big enough to measure.  when shuffled, the items are not
+// in memory in the order of their keys, so every step of the scan is a
+// cache miss.
+static void timeScan(int count, int repeat, bool shuffled)
+{
+    std::vector<int> keys(count);
+    for (int i = 0; i < count; ++i)
+    {
+        keys[i] = i;
+    }
+    if (shuffled)
+    {
+        std::mt19937 gen(count);
+        std::shuffle(keys.begin(), keys.end(), gen);
+    }
+
+    BBuilder builder;
+    std::deque<BItem> items;
+    for (int i = 0; i < count; ++i)
+    {
+        items.emplace_back(builder, keys[i], i);
+    }
+    std::unique_ptr<BMap> map(new BMap(builder));
+    std::vector<int> values(count);
+    for (int i = 0; i < count; ++i)
+    {
+        values[keys[i]] = i;
+    }
+
+    long long mapSum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r)
+    {
+        BMap::TSequence seq = map->sequence();
+        for (BMap::TSequence::const_iterator it = seq.begin(); it != seq.end(); ++it)
+        {
+            mapSum += it->val();
+        }
+    }
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+    const double mapTime = std::chrono::duration<double, std::milli>(stop - start).count();
+
+    long long arraySum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r)
+    {
+        for (const int value : values)
+        {
+            arraySum += value;
+        }
+    }
+    stop = std::chrono::steady_clock::now();
+    const double arrayTime = std::chrono::duration<double, std::milli>(stop - start).count();
+
+    // make sure the result is used and is correct
+    if (mapSum != arraySum)
+    {
+        std::cout << "bad scan of " << count << std::endl;
+    }
+    std::cout << "items=" << count << " x" << repeat << (shuffled ? " shuffled" : " sorted") << " map=" << mapTime
+              << "ms array=" << arrayTime << "ms" << std::endl;
+}
+
+void benchScan()
+{
+    std::cout << "Start Bench Scan" << std::endl;
+    const int counts[] = {1000, 50000, 1000000};
+    for (int count : counts)
+    {
+        const int repeat = 1000000 / count;
+        timeScan(count, repeat, true);
+        timeScan(count, repeat, false);
+    }
+    std::cout << "Stop Bench" << std::endl;
+}
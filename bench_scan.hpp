@@ -0,0 +1,11 @@
+//
+//  bench_scan.hpp
+//  StaticMap
+//
+
+#ifndef bench_scan_hpp
+#define bench_scan_hpp
+
+void benchScan();
+
+#endif /* bench_scan_hpp */
@@ -0,0 +1,69 @@
+//
+//  bench_sort.cpp
+//  StaticMap
+//
+
+#include "bench_sort.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "unimap.hpp"
+
+typedef static_map::UniMap<int, int, std::less<int>> BMap;
+typedef BMap::Item BItem;
+typedef BMap::Builder BBuilder;
+
+// times the construction of a map of count items, which is the sort plus
+// the tree build that happen during static initialization.  the items are
+// made on the heap here only because the counts are too big to declare.
+static double timeStartup(int count, bool shuffled)
+{
+    std::vector<int> keys(count);
+    for (int i = 0; i < count; ++i)
+    {
+        keys[i] = i;
+    }
+    if (shuffled)
+    {
+        std::mt19937 gen(count);
+        std::shuffle(keys.begin(), keys.end(), gen);
+    }
+
+    BBuilder builder;
+    std::deque<BItem> items;
+    for (int i = 0; i < count; ++i)
+    {
+        items.emplace_back(builder, keys[i], i);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::unique_ptr<BMap> map(new BMap(builder));
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+    // make sure the result is used and is correct
+    const BItem* item = map->findKey(count / 2);
+    if (!item || item->key() != count / 2)
+    {
+        std::cout << "bad map of " << count << std::endl;
+    }
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+void benchSort()
+{
+    std::cout << "Start Bench Sort" << std::endl;
+    const int counts[] = {1000, 10000, 100000};
+    for (int count : counts)
+    {
+        double shuffled = timeStartup(count, true);
+        double sorted = timeStartup(count, false);
+        std::cout << "items=" << count << " shuffled=" << shuffled << "ms sorted=" << sorted << "ms" << std::endl;
+    }
+    std::cout << "Stop Bench" << std::endl;
+}
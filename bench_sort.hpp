@@ -0,0 +1,11 @@
+//
+//  bench_sort.hpp
+//  StaticMap
+//
+
+#ifndef bench_sort_hpp
+#define bench_sort_hpp
+
+void benchSort();
+
+#endif /* bench_sort_hpp */
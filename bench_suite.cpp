@@ -0,0 +1,622 @@
+//
+//  bench_suite.cpp
+//  StaticMap
+//
+
+#include "bench_suite.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bimap.hpp"
+#include "enummap.hpp"
+#include "refmap.hpp"
+#include "unimap.hpp"
+
+//
+// Each run makes a map of some size with one kind of key, then times:
+//   build   -- constructing the map, once its items are made.  for the
+//              static maps, the items are made first, since they would be
+//              static instances; for the std containers, it is inserting
+//   hit     -- finding random keys that are in the map
+//   miss    -- finding random keys that are not in the map
+//   iterate -- going through all of the items in order, per item
+// and writes a row of CSV for each.  the runs are slow at the biggest sizes,
+// so the whole suite takes a minute or two.
+//
+
+// the values are made by casting, as Enum takes enums that are not scoped
+enum BenchEnum : int
+{
+};
+
+// the lookups done for each of hit and miss
+static const size_t s_lookups = 1 << 18;
+// the items gone through for iterate
+static const size_t s_visits = 1 << 20;
+
+// where the results go so that the work is not optimized away
+static volatile long long s_sink = 0;
+
+// the slots of a map that searches its tree, which has no storage
+struct NoSlot
+{
+};
+
+//
+// the kinds of key.  the static maps use TKey ordered by TSort, and the std
+// containers use TStd, so strings are std::string there as they would be
+//
+template<typename TKey>
+struct BenchKey;
+
+template<>
+struct BenchKey<int>
+{
+    typedef std::less<int> TSort;
+    typedef int TStd;
+    static const char* name() { return "int"; }
+    static int make(uint32_t n, std::deque<std::string>&) { return static_cast<int>(n); }
+};
+
+template<>
+struct BenchKey<BenchEnum>
+{
+    typedef std::less<BenchEnum> TSort;
+    typedef BenchEnum TStd;
+    static const char* name() { return "enum"; }
+    static BenchEnum make(uint32_t n, std::deque<std::string>&) { return static_cast<BenchEnum>(n); }
+};
+
+template<>
+struct BenchKey<const char*>
+{
+    typedef static_map::StrLess TSort;
+    typedef std::string TStd;
+    static const char* name() { return "string"; }
+    // the numbers are scrambled so that the strings do not sort the way
+    // that they were made
+    static const char* make(uint32_t n, std::deque<std::string>& strings)
+    {
+        strings.push_back("key_" + std::to_string(n * 2654435761u));
+        return strings.back().c_str();
+    }
+};
+
+// the keys of a run: the keys of the map in random order, and the keys
+// to look up that are and are not in it
+template<typename TKey>
+struct BenchKeys
+{
+    std::vector<TKey> m_keys;
+    std::vector<TKey> m_hits;
+    std::vector<TKey> m_misses;
+    std::deque<std::string> m_strings;
+};
+
+template<typename TKey>
+static void makeKeys(size_t size, BenchKeys<TKey>& keys)
+{
+    // the keys are the even numbers, and the misses the odd ones
+    for (size_t i = 0; i < size; ++i)
+    {
+        keys.m_keys.push_back(BenchKey<TKey>::make(static_cast<uint32_t>(2 * i), keys.m_strings));
+    }
+    std::mt19937 gen(static_cast<uint32_t>(size));
+    std::shuffle(keys.m_keys.begin(), keys.m_keys.end(), gen);
+    std::uniform_int_distribution<size_t> pick(0, size - 1);
+    for (size_t i = 0; i < s_lookups; ++i)
+    {
+        keys.m_hits.push_back(keys.m_keys[pick(gen)]);
+        keys.m_misses.push_back(BenchKey<TKey>::make(static_cast<uint32_t>(2 * pick(gen) + 1), keys.m_strings));
+    }
+}
+
+//
+// the maps.  each has the type of key it looks up, how to make one from a
+// key, prepare to make what is not timed, build to make the map, find, and
+// iterate, which gives back the sum of the values
+//
+
+template<typename TKey, template<typename, typename, typename, typename> class TLookup, typename TSlot>
+class UniMapBench
+{
+public:
+    typedef static_map::UniMap<TKey, int, typename BenchKey<TKey>::TSort, TLookup> TMap;
+    typedef TKey TQuery;
+
+public:
+    explicit UniMapBench(size_t slotCount) : m_builder(), m_items(), m_slots(slotCount), m_map() {}
+    static TQuery queryOf(const TKey& key) { return key; }
+
+public:
+    void prepare(const std::vector<TKey>& keys)
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            m_items.emplace_back(m_builder, keys[i], static_cast<int>(i));
+        }
+    }
+    void build() { m_map.reset(new TMap(m_builder, storageOf(m_slots))); }
+    bool find(const TQuery& key) const { return m_map->findKey(key) != nullptr; }
+    long long iterate() const
+    {
+        long long sum = 0;
+        typename TMap::TSequence seq = m_map->sequence();
+        for (typename TMap::TIterator it = seq.begin(); it != seq.end(); ++it)
+        {
+            sum += it->val();
+        }
+        return sum;
+    }
+
+private:
+    template<typename TS>
+    static typename TMap::TIndexStorage storageOf(std::vector<TS>& slots)
+    {
+        return typename TMap::TIndexStorage(slots.data(), slots.size());
+    }
+    static typename TMap::TIndexStorage storageOf(std::vector<NoSlot>&) { return typename TMap::TIndexStorage(); }
+
+private:
+    typename TMap::Builder m_builder;
+    std::deque<typename TMap::Item> m_items;
+    std::vector<TSlot> m_slots;
+    std::unique_ptr<TMap> m_map;
+};
+
+template<typename TKey>
+struct BenchRecord
+{
+    TKey m_key;
+    int m_val;
+    const TKey& key() const { return m_key; }
+};
+
+template<typename TKey>
+class RefMapBench
+{
+public:
+    typedef BenchRecord<TKey> TRecord;
+    typedef static_map::RefMap<TRecord, TKey, static_map::RefGetKey<TRecord, TKey>, typename BenchKey<TKey>::TSort>
+        TMap;
+    typedef TKey TQuery;
+
+public:
+    RefMapBench() : m_records(), m_builder(), m_items(), m_map() {}
+    static TQuery queryOf(const TKey& key) { return key; }
+
+public:
+    void prepare(const std::vector<TKey>& keys)
+    {
+        m_records.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            m_records[i].m_key = keys[i];
+            m_records[i].m_val = static_cast<int>(i);
+            m_items.emplace_back(m_builder, m_records[i]);
+        }
+    }
+    void build() { m_map.reset(new TMap(m_builder)); }
+    bool find(const TQuery& key) const { return m_map->findKey(key) != nullptr; }
+    long long iterate() const
+    {
+        long long sum = 0;
+        typename TMap::TSequence seq = m_map->sequence();
+        for (typename TMap::TIterator it = seq.begin(); it != seq.end(); ++it)
+        {
+            sum += it->m_val;
+        }
+        return sum;
+    }
+
+private:
+    std::vector<TRecord> m_records;
+    typename TMap::Builder m_builder;
+    std::deque<typename TMap::Item> m_items;
+    std::unique_ptr<TMap> m_map;
+};
+
+// a BiMap from the key to an int, found by the key
+template<typename TKey>
+class BiMapBench
+{
+public:
+    typedef static_map::BiMap<TKey, int, typename BenchKey<TKey>::TSort> TMap;
+    typedef TKey TQuery;
+
+public:
+    BiMapBench() : m_builder(), m_items(), m_map() {}
+    static TQuery queryOf(const TKey& key) { return key; }
+
+public:
+    void prepare(const std::vector<TKey>& keys)
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            m_items.emplace_back(m_builder, keys[i], static_cast<int>(i));
+        }
+    }
+    void build() { m_map.reset(new TMap(m_builder)); }
+    bool find(const TQuery& key) const { return m_map->findKey1(key) != nullptr; }
+    long long iterate() const
+    {
+        long long sum = 0;
+        typename TMap::TSequence1 seq = m_map->sequence1();
+        for (typename TMap::TSequence1::const_iterator it = seq.begin(); it != seq.end(); ++it)
+        {
+            sum += it->key2();
+        }
+        return sum;
+    }
+
+private:
+    typename TMap::Builder m_builder;
+    std::deque<typename TMap::Item> m_items;
+    std::unique_ptr<TMap> m_map;
+};
+
+// an Enum with its value and name slots, found by value for enum keys and
+// by name for string keys
+template<typename TKey>
+class EnumBench
+{
+public:
+    typedef static_map::Enum<BenchEnum> TEnum;
+    typedef TEnum::Map TMap;
+    typedef TKey TQuery;
+
+public:
+    EnumBench() : m_builder(), m_items(), m_names(), m_valueSlots(), m_nameSlots(), m_map() {}
+    static TQuery queryOf(const TKey& key) { return key; }
+
+public:
+    void prepare(const std::vector<TKey>& keys)
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            addItem(keys[i], i);
+        }
+        // the values are even numbers, or the index for string keys
+        m_valueSlots.resize(2 * keys.size());
+        m_nameSlots.resize(TEnum::NameIndex::slotsFor(keys.size()));
+    }
+    void build()
+    {
+        m_map.reset(new TMap(m_builder, TEnum::ValueIndex::Storage(m_valueSlots.data(), m_valueSlots.size()),
+                             TEnum::NameIndex::Storage(m_nameSlots.data(), m_nameSlots.size())));
+    }
+    bool find(const TQuery& key) const { return findIt(key); }
+    long long iterate() const
+    {
+        long long sum = 0;
+        TMap::TSequence1 seq = m_map->sequence1();
+        for (TMap::TSequence1::const_iterator it = seq.begin(); it != seq.end(); ++it)
+        {
+            sum += static_cast<int>(it->key1());
+        }
+        return sum;
+    }
+
+private:
+    void addItem(BenchEnum key, size_t)
+    {
+        m_names.push_back("VALUE_" + std::to_string(static_cast<int>(key)));
+        m_items.emplace_back(m_builder, key, m_names.back().c_str());
+    }
+    void addItem(const char* key, size_t i) { m_items.emplace_back(m_builder, static_cast<BenchEnum>(i), key); }
+    bool findIt(BenchEnum key) const { return TEnum::enumToString(*m_map, key).first; }
+    bool findIt(const char* key) const { return TEnum::stringToEnum(*m_map, key).first; }
+
+private:
+    TEnum::Builder m_builder;
+    std::deque<TEnum::Item> m_items;
+    std::deque<std::string> m_names;
+    std::vector<TEnum::ValueSlot> m_valueSlots;
+    std::vector<TEnum::NameSlot> m_nameSlots;
+    std::unique_ptr<TMap> m_map;
+};
+
+template<typename TKey>
+class StdMapBench
+{
+public:
+    typedef typename BenchKey<TKey>::TStd TQuery;
+
+public:
+    StdMapBench() : m_keys(), m_map() {}
+    static TQuery queryOf(const TKey& key) { return TQuery(key); }
+
+public:
+    void prepare(const std::vector<TKey>& keys)
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            m_keys.push_back(queryOf(keys[i]));
+        }
+    }
+    void build()
+    {
+        for (size_t i = 0; i < m_keys.size(); ++i)
+        {
+            m_map.insert(std::make_pair(m_keys[i], static_cast<int>(i)));
+        }
+    }
+    bool find(const TQuery& key) const { return m_map.find(key) != m_map.end(); }
+    long long iterate() const
+    {
+        long long sum = 0;
+        for (typename std::map<TQuery, int>::const_iterator it = m_map.begin(); it != m_map.end(); ++it)
+        {
+            sum += it->second;
+        }
+        return sum;
+    }
+
+private:
+    std::vector<TQuery> m_keys;
+    std::map<TQuery, int> m_map;
+};
+
+template<typename TKey>
+class StdUnorderedMapBench
+{
+public:
+    typedef typename BenchKey<TKey>::TStd TQuery;
+
+public:
+    StdUnorderedMapBench() : m_keys(), m_map() {}
+    static TQuery queryOf(const TKey& key) { return TQuery(key); }
+
+public:
+    void prepare(const std::vector<TKey>& keys)
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            m_keys.push_back(queryOf(keys[i]));
+        }
+    }
+    void build()
+    {
+        m_map.reserve(m_keys.size());
+        for (size_t i = 0; i < m_keys.size(); ++i)
+        {
+            m_map.insert(std::make_pair(m_keys[i], static_cast<int>(i)));
+        }
+    }
+    bool find(const TQuery& key) const { return m_map.find(key) != m_map.end(); }
+    // not in order, but every item
+    long long iterate() const
+    {
+        long long sum = 0;
+        for (typename std::unordered_map<TQuery, int>::const_iterator it = m_map.begin(); it != m_map.end(); ++it)
+        {
+            sum += it->second;
+        }
+        return sum;
+    }
+
+private:
+    std::vector<TQuery> m_keys;
+    std::unordered_map<TQuery, int> m_map;
+};
+
+template<typename TKey>
+class SortedVectorBench
+{
+public:
+    typedef typename BenchKey<TKey>::TStd TQuery;
+    typedef std::pair<TQuery, int> TPair;
+
+public:
+    SortedVectorBench() : m_keys(), m_items() {}
+    static TQuery queryOf(const TKey& key) { return TQuery(key); }
+
+public:
+    void prepare(const std::vector<TKey>& keys)
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            m_keys.push_back(queryOf(keys[i]));
+        }
+    }
+    void build()
+    {
+        m_items.reserve(m_keys.size());
+        for (size_t i = 0; i < m_keys.size(); ++i)
+        {
+            m_items.push_back(std::make_pair(m_keys[i], static_cast<int>(i)));
+        }
+        std::sort(m_items.begin(), m_items.end(), &pairLess);
+    }
+    bool find(const TQuery& key) const
+    {
+        typename std::vector<TPair>::const_iterator it =
+            std::lower_bound(m_items.begin(), m_items.end(), key, &keyLess);
+        return it != m_items.end() && !(key < it->first);
+    }
+    long long iterate() const
+    {
+        long long sum = 0;
+        for (typename std::vector<TPair>::const_iterator it = m_items.begin(); it != m_items.end(); ++it)
+        {
+            sum += it->second;
+        }
+        return sum;
+    }
+
+private:
+    static bool pairLess(const TPair& lhs, const TPair& rhs) { return lhs.first < rhs.first; }
+    static bool keyLess(const TPair& lhs, const TQuery& rhs) { return lhs.first < rhs; }
+
+private:
+    std::vector<TQuery> m_keys;
+    std::vector<TPair> m_items;
+};
+
+//
+// the runs
+//
+
+static double nsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void writeRow(std::ostream& out, const char* map, const char* key, size_t size, const char* measure,
+                     size_t ops, double ns)
+{
+    const double perOp = ns / static_cast<double>(ops);
+    out << map << "," << key << "," << size << "," << measure << "," << ops << "," << perOp << "," << 1e9 / perOp
+        << std::endl;
+}
+
+template<typename TBench>
+static size_t timeFinds(const TBench& bench, const std::vector<typename TBench::TQuery>& queries, double& ns)
+{
+    size_t found = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        found += bench.find(queries[i]) ? 1 : 0;
+    }
+    ns = nsSince(start);
+    return found;
+}
+
+template<typename TBench, typename TKey>
+static void runBench(std::ostream& out, const char* map, TBench& bench, const BenchKeys<TKey>& keys)
+{
+    const char* keyName = BenchKey<TKey>::name();
+    const size_t size = keys.m_keys.size();
+
+    bench.prepare(keys.m_keys);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bench.build();
+    writeRow(out, map, keyName, size, "build", size, nsSince(start));
+
+    std::vector<typename TBench::TQuery> hits;
+    std::vector<typename TBench::TQuery> misses;
+    for (size_t i = 0; i < s_lookups; ++i)
+    {
+        hits.push_back(TBench::queryOf(keys.m_hits[i]));
+        misses.push_back(TBench::queryOf(keys.m_misses[i]));
+    }
+    double ns = 0;
+    if (timeFinds(bench, hits, ns) != s_lookups)
+        std::cerr << "bad hits of " << map << " " << keyName << " " << size << std::endl;
+    writeRow(out, map, keyName, size, "hit", s_lookups, ns);
+    if (timeFinds(bench, misses, ns) != 0)
+        std::cerr << "bad misses of " << map << " " << keyName << " " << size << std::endl;
+    writeRow(out, map, keyName, size, "miss", s_lookups, ns);
+
+    const size_t repeat = std::max(s_visits / size, static_cast<size_t>(1));
+    long long sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repeat; ++r)
+    {
+        sum += bench.iterate();
+    }
+    writeRow(out, map, keyName, size, "iterate", repeat * size, nsSince(start));
+    s_sink = s_sink + sum;
+}
+
+// the DenseIndex only takes integer and enum keys
+template<typename TKey>
+static void runDense(std::ostream& out, const BenchKeys<TKey>& keys, std::true_type)
+{
+    typedef typename UniMapBench<TKey, static_map::DenseIndex, NoSlot>::TMap::TIndex DIndex;
+    // the keys are even, so they span twice their number
+    UniMapBench<TKey, static_map::DenseIndex, typename DIndex::Slot> bench(2 * keys.m_keys.size());
+    runBench(out, "unimap_dense", bench, keys);
+}
+
+template<typename TKey>
+static void runDense(std::ostream&, const BenchKeys<TKey>&, std::false_type)
+{
+}
+
+// Enum has enums for its values and strings for its names
+template<typename TKey>
+static void runEnum(std::ostream& out, const BenchKeys<TKey>& keys, std::true_type)
+{
+    EnumBench<TKey> bench;
+    runBench(out, "enum", bench, keys);
+}
+
+template<typename TKey>
+static void runEnum(std::ostream&, const BenchKeys<TKey>&, std::false_type)
+{
+}
+
+template<typename TKey>
+static void runSize(std::ostream& out, size_t size)
+{
+    typedef typename UniMapBench<TKey, static_map::EytzingerIndex, NoSlot>::TMap::TIndex EIndex;
+    typedef typename UniMapBench<TKey, static_map::STreeIndex, NoSlot>::TMap::TIndex SIndex;
+    typedef typename UniMapBench<TKey, static_map::PerfectHashIndex, NoSlot>::TMap::TIndex PIndex;
+
+    BenchKeys<TKey> keys;
+    makeKeys(size, keys);
+    {
+        UniMapBench<TKey, static_map::TreeIndex, NoSlot> bench(0);
+        runBench(out, "unimap_tree", bench, keys);
+    }
+    {
+        UniMapBench<TKey, static_map::EytzingerIndex, typename EIndex::Slot> bench(size);
+        runBench(out, "unimap_eytzinger", bench, keys);
+    }
+    {
+        UniMapBench<TKey, static_map::STreeIndex, typename SIndex::Block> bench(SIndex::blocksFor(size));
+        runBench(out, "unimap_stree", bench, keys);
+    }
+    {
+        UniMapBench<TKey, static_map::PerfectHashIndex, typename PIndex::Slot> bench(PIndex::slotsFor(size));
+        runBench(out, "unimap_perfecthash", bench, keys);
+    }
+    runDense(out, keys, std::integral_constant<bool, !std::is_pointer<TKey>::value>());
+    {
+        RefMapBench<TKey> bench;
+        runBench(out, "refmap", bench, keys);
+    }
+    {
+        BiMapBench<TKey> bench;
+        runBench(out, "bimap", bench, keys);
+    }
+    runEnum(out, keys, std::integral_constant<bool, !std::is_same<TKey, int>::value>());
+    {
+        StdMapBench<TKey> bench;
+        runBench(out, "std_map", bench, keys);
+    }
+    {
+        StdUnorderedMapBench<TKey> bench;
+        runBench(out, "std_unordered_map", bench, keys);
+    }
+    {
+        SortedVectorBench<TKey> bench;
+        runBench(out, "sorted_vector", bench, keys);
+    }
+}
+
+void benchSuite(std::ostream& out)
+{
+    out << "map,key,size,measure,ops,ns_per_op,ops_per_sec" << std::endl;
+    const size_t sizes[] = {8, 64, 512, 4096, 32768, 262144, 1048576};
+    for (size_t size : sizes)
+    {
+        runSize<int>(out, size);
+        runSize<BenchEnum>(out, size);
+        runSize<const char*>(out, size);
+    }
+}
@@ -0,0 +1,16 @@
+//
+//  bench_suite.hpp
+//  StaticMap
+//
+
+#ifndef bench_suite_hpp
+#define bench_suite_hpp
+
+#include <iosfwd>
+
+// times building, finding and iterating each of the maps and lookup
+// indexes next to std::map, std::unordered_map and a sorted std::vector, at
+// sizes from 8 to 1M with int, enum and string keys, writing CSV to out
+void benchSuite(std::ostream& out);
+
+#endif /* bench_suite_hpp */
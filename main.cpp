@@ -6,16 +6,61 @@
 //  Copyright © 2020 Daniel Pav. All rights reserved.
 //
 
+#include <cstring>
+#include <iostream>
+
+#include "bench_find.hpp"
+#include "bench_scan.hpp"
+#include "bench_sort.hpp"
+#include "bench_suite.hpp"
 #include "test_bimap.hpp"
+#include "test_constmap.hpp"
+#include "test_mappedmap.hpp"
+#include "test_multiindexmap.hpp"
+#include "test_radixmap.hpp"
 #include "test_unimap.hpp"
 #include "test_refmap.hpp"
+#include "test_tablemap.hpp"
 
 int main(int argc, const char* argv[])
 {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+    {
+        benchSort();
+        benchScan();
+        benchFind();
+        return 0;
+    }
+    // the same maps next to the std containers, as CSV for tracking
+    if (argc > 1 && strcmp(argv[1], "--bench-csv") == 0)
+    {
+        benchSuite(std::cout);
+        return 0;
+    }
+
     testUniMap();
+    testUniMapEytzinger();
+    testUniMapSTree();
+    testUniMapPerfectHash();
+    testUniMapFindKeys();
+    testUniMapLazy();
+    testUniMapDuplicates();
+    testUniMapStats();
+    testUniMapWeights();
+    testUniMapRanked();
     testRefMap();
+    testRefMapEytzinger();
+    testRefMapRange();
+    testRefMapMulti();
     testBiMap1();
     testBiMap2();
     testBiMap3();
+    testBiMapSTree();
+    testBiMapDuplicates();
+    testConstMap();
+    testMappedMap();
+    testTableMap();
+    testRadixMap();
+    testMultiIndexMap();
     return 0;
 }
@@ -10,8 +10,14 @@
 #define bimap_hpp
 
 #include "builderbase.hpp"
+#include "denseindex.hpp"
+#include "eytzinger.hpp"
 #include "itemtree.hpp"
+#include "mapstats.hpp"
+#include "perfecthash.hpp"
+#include "ranked.hpp"
 #include "sequence.hpp"
+#include "stree.hpp"
 
 #include <functional>
 
@@ -22,15 +28,19 @@ namespace static_map
 //
 //
 
-template<typename TKey1, typename TKey2, typename TKey1Sort = std::less<TKey1>, typename TKey2Sort = std::less<TKey2>>
+template<typename TKey1, typename TKey2, typename TKey1Sort = std::less<TKey1>, typename TKey2Sort = std::less<TKey2>,
+         template<typename, typename, typename, typename> class TLookup1 = TreeIndex,
+         template<typename, typename, typename, typename> class TLookup2 = TreeIndex, typename TStats = NoStats>
 class BiMap
 {
 public:
     class Builder;
     class Item;
-    typedef BiMap<TKey1, TKey2, TKey1Sort, TKey2Sort> ThisType;
+    typedef BiMap<TKey1, TKey2, TKey1Sort, TKey2Sort, TLookup1, TLookup2, TStats> ThisType;
     typedef Builder TBuilder;
     typedef Item TData;
+    typedef DuplicatePolicy<TData> TDuplicates;
+    typedef WeightPolicy<TData> TWeights;
 
 private:
     class GetKey1;
@@ -44,6 +54,18 @@ private:
 public:
     typedef Sequence<TData, TKey1, TKey1Get, TKey1Sort> TSequence1;
     typedef Sequence<TData, TKey2, TKey2Get, TKey2Sort> TSequence2;
+    typedef typename TSequence1::const_iterator TIterator1;
+    typedef typename TSequence2::const_iterator TIterator2;
+    typedef RankedSequence<TData, TKey1, TKey1Get, TKey1Sort> TRanked1;
+    typedef RankedSequence<TData, TKey2, TKey2Get, TKey2Sort> TRanked2;
+    typedef TLookup1<TData, TKey1, TKey1Get, TKey1Sort> TIndex1;
+    typedef TLookup2<TData, TKey2, TKey2Get, TKey2Sort> TIndex2;
+    typedef typename TIndex1::Storage TIndex1Storage;
+    typedef typename TIndex2::Storage TIndex2Storage;
+
+private:
+    typedef StatsFuncs<Tree1Util, TIndex1, TStats> Stats1Util;
+    typedef StatsFuncs<Tree2Util, TIndex2, TStats> Stats2Util;
 
 public:
     class Builder : public BiBuilderBase
@@ -52,8 +74,23 @@ public:
         typedef BiBuilderBase Base;
 
     public:
-        Builder() : Base() {}
+        constexpr Builder() : Base(), m_duplicates(), m_weights() {}
+        constexpr explicit Builder(const TDuplicates& duplicates, const TWeights& weights = TWeights()) :
+            Base(),
+            m_duplicates(duplicates),
+            m_weights(weights)
+        {
+        }
+        constexpr explicit Builder(const TWeights& weights) : Base(), m_duplicates(), m_weights(weights) {}
         ~Builder() = default;
+
+    public:
+        const TDuplicates& getDuplicates() const { return m_duplicates; }
+        const TWeights& getWeights() const { return m_weights; }
+
+    private:
+        TDuplicates m_duplicates;
+        TWeights m_weights;
     };
 
 private:
@@ -184,14 +221,35 @@ private:
     };
 
 public:
-    BiMap(TBuilder& builder) : m_tree1(), m_tree2()
+    BiMap(TBuilder& builder,
+          const TIndex1Storage& storage1 = TIndex1Storage(),
+          const TIndex2Storage& storage2 = TIndex2Storage(),
+          const char* statsName = nullptr) :
+        m_tree1(),
+        m_tree2(),
+        m_index1(storage1),
+        m_index2(storage2),
+        m_stats1(statsName, "key1"),
+        m_stats2(statsName, "key2")
     {
         ItemArray& array1 = builder.getUnsortedArray1();
-        Tree1Util::sortInPlace(array1);
-        m_tree1.constructFrom(array1);
         ItemArray& array2 = builder.getUnsortedArray2();
+        Tree1Util::sortInPlace(array1);
         Tree2Util::sortInPlace(array2);
-        m_tree2.constructFrom(array2);
+        if (builder.getDuplicates().isChecked())
+        {
+            // an item dropped from either side is dropped from both
+            ItemArray dropped1;
+            Tree1Util::removeDuplicates(array1, builder.getDuplicates(), &dropped1);
+            Tree2Util::removeDropped(array2, dropped1);
+            ItemArray dropped2;
+            Tree2Util::removeDuplicates(array2, builder.getDuplicates(), &dropped2);
+            Tree1Util::removeDropped(array1, dropped2);
+        }
+        builder.getWeights().construct(m_tree1, array1);
+        m_index1.build(m_tree1);
+        builder.getWeights().construct(m_tree2, array2);
+        m_index2.build(m_tree2);
     }
     ~BiMap() = default;
 
@@ -202,13 +260,56 @@ private:
 public:
     const TData* findKey1(const TKey1& key) const
     {
-        const TStructItem* item = static_cast<const TStructItem*>(Tree1Util::findInTree(m_tree1, key));
+        const TStructItem* item = static_cast<const TStructItem*>(Stats1Util::find(m_index1, m_tree1, m_stats1, key));
         return item ? &(item->data()) : nullptr;
     }
 
     const TData* findKey2(const TKey2& key) const
     {
-        const TStructItem* item = static_cast<const TStructItem*>(Tree2Util::findInTree(m_tree2, key));
+        const TStructItem* item = static_cast<const TStructItem*>(Stats2Util::find(m_index2, m_tree2, m_stats2, key));
+        return item ? &(item->data()) : nullptr;
+    }
+
+    // find keys of other types that TKey1Sort or TKey2Sort can compare with
+    // the keys, like findKey of UniMap
+    template<typename TOther, typename = EnableIfTransparent<TKey1Sort, TOther>>
+    const TData* findKey1(const TOther& key) const
+    {
+        const TStructItem* item = static_cast<const TStructItem*>(Stats1Util::find(m_index1, m_tree1, m_stats1, key));
+        return item ? &(item->data()) : nullptr;
+    }
+
+    template<typename TOther, typename = EnableIfTransparent<TKey2Sort, TOther>>
+    const TData* findKey2(const TOther& key) const
+    {
+        const TStructItem* item = static_cast<const TStructItem*>(Stats2Util::find(m_index2, m_tree2, m_stats2, key));
+        return item ? &(item->data()) : nullptr;
+    }
+
+    // find many keys at once, like findKeys of UniMap
+    void findKeys1(const TKey1* keys, size_t count, const TData** items) const
+    {
+        Tree1Util::findKeys(m_index1, m_tree1, keys, count, items);
+        Stats1Util::recordMany(m_tree1, m_stats1, keys, count, items);
+    }
+
+    void findKeys2(const TKey2* keys, size_t count, const TData** items) const
+    {
+        Tree2Util::findKeys(m_index2, m_tree2, keys, count, items);
+        Stats2Util::recordMany(m_tree2, m_stats2, keys, count, items);
+    }
+
+    // the counts of the lookups of each key, if TStats keeps them
+    const TStats& getStats1() const { return m_stats1; }
+    const TStats& getStats2() const { return m_stats2; }
+    // the lookup index of each key, to tell if it was built
+    const TIndex1& getIndex1() const { return m_index1; }
+    const TIndex2& getIndex2() const { return m_index2; }
+    // the item that findKey1 and findKey2 give for a key that is not found,
+    // if any
+    const TData* getDefault() const
+    {
+        const TStructItem* item = static_cast<const TStructItem*>(m_tree1.getDefault());
         return item ? &(item->data()) : nullptr;
     }
 
@@ -226,9 +327,28 @@ public:
         return seq;
     }
 
+public:
+    // these find items by their place in the order of either key in
+    // O(log n) time, and work the same as the functions of the same name in
+    // TSequence1 and TSequence2
+    TIterator1 lowerBound1(const TKey1& key) const { return sequence1().lower_bound(key); }
+    TIterator1 upperBound1(const TKey1& key) const { return sequence1().upper_bound(key); }
+    std::pair<TIterator1, TIterator1> equalRange1(const TKey1& key) const { return sequence1().equal_range(key); }
+    TSequence1 range1(const TKey1& lo, const TKey1& hi) const { return sequence1().range(lo, hi); }
+    TSequence1 findAll1(const TKey1& key) const { return sequence1().range(key); }
+    TIterator2 lowerBound2(const TKey2& key) const { return sequence2().lower_bound(key); }
+    TIterator2 upperBound2(const TKey2& key) const { return sequence2().upper_bound(key); }
+    std::pair<TIterator2, TIterator2> equalRange2(const TKey2& key) const { return sequence2().equal_range(key); }
+    TSequence2 range2(const TKey2& lo, const TKey2& hi) const { return sequence2().range(lo, hi); }
+    TSequence2 findAll2(const TKey2& key) const { return sequence2().range(key); }
+
 private:
     ItemTree m_tree1;
     ItemTree m_tree2;
+    TIndex1 m_index1;
+    TIndex2 m_index2;
+    TStats m_stats1;
+    TStats m_stats2;
 };
 
 } // namespace static_map
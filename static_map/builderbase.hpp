@@ -9,14 +9,153 @@
 #ifndef builderbase_hpp
 #define builderbase_hpp
 
+#include <cassert>
+#include <cstdint>
+
 #include "itemtree.hpp"
 
 namespace static_map
 {
+
+//
+// DuplicatePolicy: what a map does with items that have the same key as
+// another item, given to the Builder of the map.  By default they are all
+// kept, and findKey finds any one of them.  Otherwise the map checks for
+// them in one pass after sorting and:
+//
+// assertUnique: asserts that there are none, and in a release build,
+//               keeps only the first one like firstWins
+// firstWins:    keeps only the first item with each key, in the order the
+//               items were added to the Builder
+// callback:     calls the function with the first item with the key and
+//               the duplicate, which is dropped if it returns true
+// keepInOrder:  keeps them all, next to each other in the order the items
+//               were added to the Builder, and findKey finds the first one,
+//               so the map is a multimap whose findAll gives the rest
+//
+// typedef UniMap<int, const char*> M;
+// static M::Builder s_builder(M::TDuplicates::firstWins());
+//
+// In a BiMap or MultiIndexMap, the policy is used for each key, and an item
+// dropped for one key is dropped for all of them, so that every key finds
+// the same items.
+//
+template<typename TData>
+class DuplicatePolicy
+{
+public:
+    typedef bool (*TCallback)(const TData& kept, const TData& duplicate);
+
+public:
+    constexpr DuplicatePolicy() : m_action(e_keepAll), m_callback(nullptr) {}
+    ~DuplicatePolicy() = default;
+
+public:
+    static constexpr DuplicatePolicy keepAll() { return DuplicatePolicy(e_keepAll, nullptr); }
+    static constexpr DuplicatePolicy assertUnique() { return DuplicatePolicy(e_assertUnique, nullptr); }
+    static constexpr DuplicatePolicy firstWins() { return DuplicatePolicy(e_firstWins, nullptr); }
+    static constexpr DuplicatePolicy callback(TCallback callback) { return DuplicatePolicy(e_callback, callback); }
+    static constexpr DuplicatePolicy keepInOrder() { return DuplicatePolicy(e_keepInOrder, nullptr); }
+
+public:
+    // returns true if the map must look for duplicates
+    constexpr bool isChecked() const { return m_action != e_keepAll; }
+    // returns true if the duplicate is to be dropped
+    bool operator()(const TData& kept, const TData& duplicate) const
+    {
+        switch (m_action)
+        {
+        case e_keepAll:
+            return false;
+        case e_assertUnique:
+            assert(!"duplicate key");
+            return true;
+        case e_firstWins:
+            return true;
+        case e_callback:
+            return m_callback(kept, duplicate);
+        case e_keepInOrder:
+            return false;
+        }
+        return false;
+    }
+
+private:
+    enum Action
+    {
+        e_keepAll,
+        e_assertUnique,
+        e_firstWins,
+        e_callback,
+        e_keepInOrder
+    };
+
+private:
+    constexpr DuplicatePolicy(Action action, TCallback callback) : m_action(action), m_callback(callback) {}
+
+private:
+    Action m_action;
+    TCallback m_callback;
+};
+
+//
+// WeightPolicy: how the tree of a map is shaped, given to the Builder of the
+// map.  By default the tree is balanced, so every lookup takes about log n
+// steps.  When most lookups are for a few keys, a function that gives how
+// often each item is looked up (from its data, or from a profile of a
+// running program) can be given instead, and those items are put near the
+// top (see ItemTree::constructFrom):
+//
+// static uint64_t hitsOf(const M::Item& item) { return s_profile[item.key()]; }
+// static M::Builder s_builder(M::TWeights::byWeight(hitsOf));
+//
+// In a BiMap, the weights are used for each side.
+//
+template<typename TData>
+class WeightPolicy
+{
+public:
+    typedef uint64_t (*TWeightOf)(const TData& data);
+
+public:
+    constexpr WeightPolicy() : m_weightOf(nullptr) {}
+    ~WeightPolicy() = default;
+
+public:
+    static constexpr WeightPolicy balanced() { return WeightPolicy(nullptr); }
+    static constexpr WeightPolicy byWeight(TWeightOf weightOf) { return WeightPolicy(weightOf); }
+
+public:
+    // builds the tree from the sorted array in the shape asked for
+    void construct(ItemTree& tree, ItemArray& sortedArray) const
+    {
+        if (m_weightOf)
+            tree.constructFrom(sortedArray, &weightOfItem, this);
+        else
+            tree.constructFrom(sortedArray);
+    }
+
+private:
+    constexpr explicit WeightPolicy(TWeightOf weightOf) : m_weightOf(weightOf) {}
+
+    static uint64_t weightOfItem(const StructItem* item, const void* context)
+    {
+        const WeightPolicy* policy = static_cast<const WeightPolicy*>(context);
+        return policy->m_weightOf(static_cast<const StructItemT<TData>*>(item)->data());
+    }
+
+private:
+    TWeightOf m_weightOf;
+};
+
+//
+//
+//
+
 class BuilderBase
 {
 public:
-    BuilderBase() = default;
+    constexpr BuilderBase() : m_array() {}
     ~BuilderBase() = default;
 
 private:
@@ -38,7 +177,7 @@ private:
 class BiBuilderBase
 {
 public:
-    BiBuilderBase() = default;
+    constexpr BiBuilderBase() : m_array1(), m_array2() {}
     ~BiBuilderBase() = default;
 
 private:
@@ -56,6 +195,34 @@ private:
     ItemArray m_array2;
 };
 
+//
+// MultiBuilderBase: the unsorted items of each of the N keys of a
+// MultiIndexMap
+//
+
+template<size_t N>
+class MultiBuilderBase
+{
+public:
+    constexpr MultiBuilderBase() : m_arrays() {}
+    ~MultiBuilderBase() = default;
+
+private:
+    MultiBuilderBase(const MultiBuilderBase&) = delete;
+    MultiBuilderBase& operator=(const MultiBuilderBase&) = delete;
+
+public:
+    // get access to the unsorted innards of key i
+    ItemArray& getUnsortedArray(size_t i)
+    {
+        assert(i < N);
+        return m_arrays[i];
+    }
+
+private:
+    ItemArray m_arrays[N];
+};
+
 } // namespace static_map
 
 #endif /* builderbase_hpp */
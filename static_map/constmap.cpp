@@ -0,0 +1,10 @@
+//
+//  constmap.cpp
+//  StaticMap
+//
+
+#include "constmap.hpp"
+
+namespace static_map
+{
+}
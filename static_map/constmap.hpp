@@ -0,0 +1,135 @@
+//
+//  constmap.hpp
+//  StaticMap
+//
+
+#ifndef constmap_hpp
+#define constmap_hpp
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "tablemap.hpp"
+
+namespace static_map
+{
+
+//
+// ConstStrLess: orders C strings like strcmp, but can be used at compile time
+//
+struct ConstStrLess
+{
+    constexpr bool operator()(const char* s1, const char* s2) const
+    {
+        while (*s1 && *s1 == *s2)
+        {
+            ++s1;
+            ++s2;
+        }
+        return static_cast<unsigned char>(*s1) < static_cast<unsigned char>(*s2);
+    }
+};
+
+//
+// ConstMap: a map that is sorted entirely at compile time.  Where the other
+// maps are built by items registering with a Builder during static
+// initialization, this one is made from a std::array of key/value pairs in a
+// constexpr constructor, which sorts them (stably) into a flat array.  When
+// declared constexpr, the whole map is a constant in read only memory, so it
+// costs nothing at process start and is not subject to the order of static
+// initialization.
+//
+// typedef ConstMap<int, const char*, 3> M;
+// static constexpr M s_map(M::TPairs{{{3, "THREE"}, {1, "ONE"}, {2, "TWO"}}});
+//
+// The sorted items are the Items of a TableMap, table() gives the TableMap
+// over them, and findKey and sequence are those of the TableMap.  findKey can
+// also be used at compile time.  TKey and TVal must be literal types and
+// TKeySort must be usable at compile time (std::less is, and ConstStrLess
+// can be used for C strings).  There is no default item, a key that is not
+// found gives nullptr.
+//
+template<typename TKey, typename TVal, size_t N, typename TKeySort = std::less<TKey>>
+class ConstMap
+{
+    static_assert(N > 0, "ConstMap needs at least one item");
+
+public:
+    typedef ConstMap<TKey, TVal, N, TKeySort> ThisType;
+    typedef TableMap<TKey, TVal, TKeySort> TTable;
+    typedef typename TTable::Item Item;
+    typedef typename TTable::Sequence Sequence;
+    typedef Item TData;
+    typedef Sequence TSequence;
+    typedef std::pair<TKey, TVal> TPair;
+    typedef std::array<TPair, N> TPairs;
+
+private:
+    // the positions of the pairs, in sorted order
+    struct Order
+    {
+        size_t m_index[N];
+    };
+
+public:
+    constexpr explicit ConstMap(const TPairs& pairs) : ConstMap(pairs, sortedOrder(pairs), std::make_index_sequence<N>())
+    {
+    }
+
+private:
+    template<size_t... I>
+    constexpr ConstMap(const TPairs& pairs, const Order& order, std::index_sequence<I...>) :
+        m_items{Item(pairs[order.m_index[I]].first, pairs[order.m_index[I]].second)...}
+    {
+    }
+
+public:
+    // finds the key in O(log n) time, returns nullptr if not found
+    constexpr const TData* findKey(const TKey& key) const { return TTable::findIn(m_items, N, key); }
+
+public:
+    constexpr TTable table() const { return TTable(m_items); }
+    constexpr TSequence sequence() const { return TSequence(m_items, N); }
+    constexpr size_t size() const { return N; }
+
+private:
+    // a stable bottom-up merge sort of the positions of the pairs
+    static constexpr Order sortedOrder(const TPairs& pairs)
+    {
+        Order order{};
+        Order merged{};
+        for (size_t i = 0; i < N; ++i)
+        {
+            order.m_index[i] = i;
+        }
+        TKeySort compare{};
+        for (size_t width = 1; width < N; width *= 2)
+        {
+            for (size_t low = 0; low < N; low += 2 * width)
+            {
+                const size_t mid = (low + width < N) ? low + width : N;
+                const size_t high = (low + 2 * width < N) ? low + 2 * width : N;
+                size_t left = low;
+                size_t right = mid;
+                for (size_t out = low; out < high; ++out)
+                {
+                    // only take from the right if it is strictly less
+                    const bool takeRight = (right < high) &&
+                        ((left == mid) || compare(pairs[order.m_index[right]].first, pairs[order.m_index[left]].first));
+                    merged.m_index[out] = takeRight ? order.m_index[right++] : order.m_index[left++];
+                }
+            }
+            order = merged;
+        }
+        return order;
+    }
+
+private:
+    Item m_items[N];
+};
+
+} // namespace static_map
+
+#endif /* constmap_hpp */
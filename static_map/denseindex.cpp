@@ -0,0 +1,10 @@
+//
+//  denseindex.cpp
+//  StaticMap
+//
+
+#include "denseindex.hpp"
+
+namespace static_map
+{
+}
@@ -0,0 +1,206 @@
+//
+//  denseindex.hpp
+//  StaticMap
+//
+
+#ifndef denseindex_hpp
+#define denseindex_hpp
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "itemtree.hpp"
+
+namespace static_map
+{
+
+//
+// DenseIndex: a lookup index for a map with integer or enum keys that are
+// mostly packed into a small range, like the values of an enum.  When the
+// map is constructed, the smallest and largest keys are found, and if the
+// range between them is dense enough and fits in the array given by the
+// caller, the array is filled so that slot (key - smallest) holds the item.
+// A lookup is then a subtraction, a range check and an array read.
+//
+// typedef UniMap<Color, const char*, std::less<int>, DenseIndex> M;
+// static M::TIndex::Slot s_slots[64];
+// static M s_map(s_builder, s_slots);
+//
+// The range must be no more than maxSpanPerItem times the number of items
+// (4 by default, so at least a quarter of the slots are used), which can be
+// changed with Storage(s_slots).withMaxSpanPerItem(8).  Otherwise the map
+// will search the tree instead.  Keys that are the same under
+// TKeySort must have the same value.
+//
+template<typename TData, typename TKey, typename TKeyGet, typename TKeySort>
+class DenseIndex
+{
+private:
+    typedef StructItemT<TData> TStructItem;
+    typedef TreeFuncs<TData, TKey, TKeyGet, TKeySort> TreeUtil;
+
+    static_assert(std::is_integral<TKey>::value || std::is_enum<TKey>::value,
+                  "DenseIndex needs integer or enum keys");
+
+public:
+    // the item with the key of the slot, or nullptr if there is none
+    typedef const StructItem* Slot;
+
+    // the caller supplied array of slots and how sparse it may be
+    class Storage
+    {
+    public:
+        Storage() : m_slots(nullptr), m_capacity(0), m_maxSpanPerItem(s_defaultMaxSpanPerItem) {}
+        template<size_t N>
+        Storage(Slot (&slots)[N]) : m_slots(slots), m_capacity(N), m_maxSpanPerItem(s_defaultMaxSpanPerItem)
+        {
+        }
+        Storage(Slot* slots, size_t capacity) :
+            m_slots(slots),
+            m_capacity(capacity),
+            m_maxSpanPerItem(s_defaultMaxSpanPerItem)
+        {
+        }
+
+    public:
+        // the same slots, allowing the range to be up to maxSpanPerItem
+        // times the number of items
+        Storage withMaxSpanPerItem(size_t maxSpanPerItem) const
+        {
+            Storage storage(*this);
+            storage.m_maxSpanPerItem = maxSpanPerItem;
+            return storage;
+        }
+
+    public:
+        Slot* slots() const { return m_slots; }
+        size_t capacity() const { return m_capacity; }
+        size_t maxSpanPerItem() const { return m_maxSpanPerItem; }
+
+    private:
+        Slot* m_slots;
+        size_t m_capacity;
+        size_t m_maxSpanPerItem;
+    };
+
+public:
+    DenseIndex() : m_storage(), m_smallest(0), m_span(0) {}
+    explicit DenseIndex(const Storage& storage) : m_storage(storage), m_smallest(0), m_span(0) {}
+    ~DenseIndex() = default;
+
+private:
+    DenseIndex(const DenseIndex&) = delete;
+    DenseIndex& operator=(const DenseIndex&) = delete;
+
+public:
+    // returns true if the slots are being used for lookups
+    bool isBuilt() const { return m_span != 0; }
+
+public:
+    // fills the slots in O(n + span) time if the keys are dense enough
+    void build(const ItemTree& tree)
+    {
+        assert(!m_span);
+        const size_t count = tree.getCount();
+        if (count == 0)
+            return;
+        // the tree is sorted, but the sort might not be by value, so look
+        // at every key for the ends of the range
+        int64_t smallest = valueOf(keyOf(tree.getFirst()));
+        int64_t largest = smallest;
+        for (const StructItem* item = tree.getFirst(); item; item = tree.getNext(item))
+        {
+            const int64_t value = valueOf(keyOf(item));
+            smallest = (value < smallest) ? value : smallest;
+            largest = (value > largest) ? value : largest;
+        }
+        const uint64_t span = static_cast<uint64_t>(largest) - static_cast<uint64_t>(smallest) + 1;
+        if (span == 0 || span > m_storage.capacity() || span > count * m_storage.maxSpanPerItem())
+            return;
+
+        Slot* slots = m_storage.slots();
+        for (uint64_t i = 0; i < span; ++i)
+        {
+            slots[i] = nullptr;
+        }
+        for (const StructItem* item = tree.getFirst(); item; item = tree.getNext(item))
+        {
+            Slot& slot = slots[static_cast<uint64_t>(valueOf(keyOf(item))) - static_cast<uint64_t>(smallest)];
+            // if keys repeat, keep the first one
+            if (!slot)
+                slot = item;
+        }
+        m_smallest = smallest;
+        m_span = span;
+    }
+
+    // finds the key in O(1) time, returns the default item if not found
+    const StructItem* find(const ItemTree& tree, const TKey& key) const
+    {
+        if (!m_span)
+            return TreeUtil::findInTree(tree, key);
+
+        const uint64_t offset = offsetOf(key);
+        const StructItem* item = (offset < m_span) ? m_storage.slots()[offset] : nullptr;
+        return item ? item : tree.getDefault();
+    }
+
+    // finds a key of another type that TKeySort can compare with the keys
+    // by searching the tree, since only a TKey has a slot
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    const StructItem* find(const ItemTree& tree, const TOther& key) const
+    {
+        return TreeUtil::findInTree(tree, key);
+    }
+
+    // does find for up to s_batchSize keys at once, with the slots of all
+    // of them prefetched before any is read
+    void findMany(const ItemTree& tree, const TKey* keys, size_t count, const StructItem** items) const
+    {
+        if (!m_span)
+        {
+            TreeUtil::findManyInTree(tree, keys, count, items);
+            return;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint64_t offset = offsetOf(keys[i]);
+            if (offset < m_span)
+                STATIC_MAP_PREFETCH(m_storage.slots() + offset);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            items[i] = find(tree, keys[i]);
+        }
+    }
+
+private:
+    static const TKey& keyOf(const StructItem* item)
+    {
+        return TKeyGet::key(static_cast<const TStructItem*>(item)->data());
+    }
+
+    static int64_t valueOf(const TKey& key) { return static_cast<int64_t>(key); }
+
+    // where the key goes in the slots, anything below the smallest wraps
+    // around to a big offset
+    uint64_t offsetOf(const TKey& key) const
+    {
+        return static_cast<uint64_t>(valueOf(key)) - static_cast<uint64_t>(m_smallest);
+    }
+
+private:
+    static const size_t s_defaultMaxSpanPerItem = 4;
+
+private:
+    Storage m_storage;
+    int64_t m_smallest;
+    uint64_t m_span;
+};
+
+} // namespace static_map
+
+#endif /* denseindex_hpp */
@@ -9,7 +9,11 @@
 #ifndef enummap_hpp
 #define enummap_hpp
 
+#include <cstring>
+#include <utility>
+
 #include "bimap.hpp"
+#include "strref.hpp"
 
 namespace static_map
 {
@@ -17,16 +21,24 @@ namespace static_map
 template<typename TEnum>
 struct Enum
 {
-    struct StrCmp
-    {
-        bool operator()(const char* s1, const char* s2) const { return (strcmp(s1, s2) < 0); }
-    };
+    // orders the names like strcmp, and lets them be found by a StrRef
+    typedef StrLess StrCmp;
 
-    typedef BiMap<TEnum, const char*, std::less<int>, StrCmp> Map;
+    // the values are found by indexing an array, and the names through a
+    // perfect hash, if the map is given the slots for them, like this:
+    // static Enum<Color>::ValueSlot s_values[16];
+    // static Enum<Color>::NameSlot s_names[Enum<Color>::NameIndex::slotsFor(3)];
+    // static Enum<Color>::Map s_map(s_builder, s_values, s_names);
+    // either can be left out by passing {} and the tree will be searched
+    typedef BiMap<TEnum, const char*, std::less<int>, StrCmp, DenseIndex, PerfectHashIndex> Map;
     typedef typename Map::Item Item;
     typedef typename Map::LeftKeyItem LeftKeyItem;
     typedef typename Map::RightKeyItem RightKeyItem;
     typedef typename Map::Builder Builder;
+    typedef typename Map::TIndex1 ValueIndex;
+    typedef typename ValueIndex::Slot ValueSlot;
+    typedef typename Map::TIndex2 NameIndex;
+    typedef typename NameIndex::Slot NameSlot;
 
     static std::pair<bool, const char*> enumToString(const Enum::Map& em, TEnum c)
     {
@@ -42,6 +54,19 @@ struct Enum
         const TEnum second = first ? i->key1() : (TEnum) 0;
         return std::make_pair(first, second);
     }
+    // the same for a name that is not NUL terminated, or a std::string,
+    // without copying it
+    static std::pair<bool, TEnum> stringToEnum(const Enum::Map& em, const StrRef& c)
+    {
+        const Item* i = em.findKey2(c);
+        const bool first = (i != nullptr);
+        const TEnum second = first ? i->key1() : (TEnum) 0;
+        return std::make_pair(first, second);
+    }
+    static std::pair<bool, TEnum> stringToEnum(const Enum::Map& em, const char* c, size_t length)
+    {
+        return stringToEnum(em, StrRef(c, length));
+    }
 };
 
 } // namespace static_map
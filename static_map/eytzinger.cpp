@@ -0,0 +1,10 @@
+//
+//  eytzinger.cpp
+//  StaticMap
+//
+
+#include "eytzinger.hpp"
+
+namespace static_map
+{
+}
@@ -0,0 +1,250 @@
+//
+//  eytzinger.hpp
+//  StaticMap
+//
+
+#ifndef eytzinger_hpp
+#define eytzinger_hpp
+
+#include <cassert>
+#include <cstddef>
+
+#include "itemtree.hpp"
+
+namespace static_map
+{
+
+//
+// EytzingerIndex: a lookup index for a map that copies the keys into a flat
+// array given by the caller, laid out in Eytzinger (breadth first) order.
+// The children of slot k are at 2k and 2k+1 (counting from 1), so the top
+// levels of the search share a few cache lines and each level can be
+// prefetched ahead of time, unlike the tree whose items are wherever the
+// static objects were put.
+//
+// Use it by giving it to the map as its index and passing a big enough
+// static array of slots to the map's constructor:
+//
+// typedef UniMap<int, const char*, std::less<int>, EytzingerIndex> M;
+// static M::TIndex::Slot s_slots[1024];
+// static M s_map(s_builder, s_slots);
+//
+// If there are more items than slots, the map will search the tree instead.
+// TKey must be default constructible and copy assignable.
+//
+template<typename TData, typename TKey, typename TKeyGet, typename TKeySort>
+class EytzingerIndex
+{
+private:
+    typedef StructItemT<TData> TStructItem;
+    typedef TreeFuncs<TData, TKey, TKeyGet, TKeySort> TreeUtil;
+
+public:
+    // a copy of the key and the item that it came from
+    struct Slot
+    {
+        TKey m_key;
+        const StructItem* m_item;
+    };
+
+    // the caller supplied array of slots
+    class Storage
+    {
+    public:
+        Storage() : m_slots(nullptr), m_capacity(0) {}
+        template<size_t N>
+        Storage(Slot (&slots)[N]) : m_slots(slots), m_capacity(N)
+        {
+        }
+        Storage(Slot* slots, size_t capacity) : m_slots(slots), m_capacity(capacity) {}
+
+    public:
+        Slot* slots() const { return m_slots; }
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        Slot* m_slots;
+        size_t m_capacity;
+    };
+
+public:
+    EytzingerIndex() : m_storage(), m_count(0) {}
+    explicit EytzingerIndex(const Storage& storage) : m_storage(storage), m_count(0) {}
+    ~EytzingerIndex() = default;
+
+private:
+    EytzingerIndex(const EytzingerIndex&) = delete;
+    EytzingerIndex& operator=(const EytzingerIndex&) = delete;
+
+public:
+    // returns true if the slots are being used for lookups
+    bool isBuilt() const { return m_count != 0; }
+
+public:
+    // copies the keys from the tree in O(n) time if there is room
+    void build(const ItemTree& tree)
+    {
+        assert(!m_count);
+        size_t count = tree.getCount();
+        if (count == 0 || count > m_storage.capacity())
+            return;
+        m_count = count;
+        size_t k = firstInOrder();
+        fillInOrder(tree, tree.getTryMiddle(), k);
+        assert(k == 0);
+    }
+
+    // finds the key in O(log n) time, returns the default item if not found
+    const StructItem* find(const ItemTree& tree, const TKey& key) const { return search(tree, key); }
+    // finds a key of another type that TKeySort can compare with the keys
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    const StructItem* find(const ItemTree& tree, const TOther& key) const
+    {
+        return search(tree, key);
+    }
+
+    // does find for up to s_batchSize keys at once, with every search going
+    // down a level before any of them goes down the next one
+    void findMany(const ItemTree& tree, const TKey* keys, size_t count, const StructItem** items) const
+    {
+        if (!m_count)
+        {
+            TreeUtil::findManyInTree(tree, keys, count, items);
+            return;
+        }
+
+        assert(count <= TreeUtil::s_batchSize);
+        size_t ks[TreeUtil::s_batchSize];
+        for (size_t i = 0; i < count; ++i)
+        {
+            ks[i] = 1;
+        }
+        // the searches all go down the same number of levels, give or take
+        // the last one
+        bool going = true;
+        while (going)
+        {
+            going = false;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (ks[i] <= m_count)
+                {
+                    ks[i] = stepDown(ks[i], keys[i]);
+                    going = true;
+                }
+            }
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            items[i] = itemAt(tree, ks[i], keys[i]);
+        }
+    }
+
+private:
+    template<typename TSearch>
+    const StructItem* search(const ItemTree& tree, const TSearch& key) const
+    {
+        if (!m_count)
+            return TreeUtil::findInTree(tree, key);
+
+        size_t k = 1;
+        while (k <= m_count)
+            k = stepDown(k, key);
+        return itemAt(tree, k, key);
+    }
+
+    // goes down a level from slot k
+    template<typename TSearch>
+    size_t stepDown(size_t k, const TSearch& key) const
+    {
+        const Slot* slots = m_storage.slots();
+        TKeySort compare;
+        // the descendants a few levels down share one cache line, if there
+        // are any, since a pointer past the slots must not be made
+        const size_t ahead = (k << s_prefetchLevels) - 1;
+        if (ahead < m_count)
+            STATIC_MAP_PREFETCH(slots + ahead);
+        // go right if the slot is less than the key, without a branch
+        return 2 * k + (compare(slots[k - 1].m_key, key) ? 1 : 0);
+    }
+
+    // the item that a search ending at k found
+    template<typename TSearch>
+    const StructItem* itemAt(const ItemTree& tree, size_t k, const TSearch& key) const
+    {
+        // undo the right turns taken after the last left turn, which leaves
+        // k at the first slot that is not less than the key, or 0 if none
+        k = undoRightTurns(k);
+        if (k != 0)
+        {
+            const Slot& slot = m_storage.slots()[k - 1];
+            TKeySort compare;
+            if (!compare(key, slot.m_key))
+                return slot.m_item;
+        }
+        return tree.getDefault();
+    }
+
+    // walk the tree in order, and place each item in the slot that comes next
+    // in the in order walk of the implied tree of slots
+    void fillInOrder(const ItemTree& tree, const StructItem* item, size_t& k)
+    {
+        if (!item)
+            return;
+        fillInOrder(tree, tree.getTrySmaller(item), k);
+        assert(k != 0);
+        Slot& slot = m_storage.slots()[k - 1];
+        slot.m_key = TKeyGet::key(static_cast<const TStructItem*>(item)->data());
+        slot.m_item = item;
+        k = nextInOrder(k);
+        fillInOrder(tree, tree.getTryLarger(item), k);
+    }
+
+    // the leftmost slot of the implied tree
+    size_t firstInOrder() const
+    {
+        size_t k = 1;
+        while (2 * k <= m_count)
+            k = 2 * k;
+        return k;
+    }
+
+    // the slot after k in the in order walk of the implied tree, 0 at the end
+    size_t nextInOrder(size_t k) const
+    {
+        if (2 * k + 1 <= m_count)
+        {
+            // the leftmost of the right child
+            k = 2 * k + 1;
+            while (2 * k <= m_count)
+                k = 2 * k;
+            return k;
+        }
+        // go up until coming from a left child
+        return undoRightTurns(k);
+    }
+
+    // shifts away the trailing ones, and then the zero before them
+    static size_t undoRightTurns(size_t k)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return k >> (__builtin_ctzll(~static_cast<unsigned long long>(k)) + 1);
+#else
+        while (k & 1)
+            k >>= 1;
+        return k >> 1;
+#endif
+    }
+
+private:
+    // prefetch as many levels ahead as fit in a cache line
+    static const size_t s_prefetchLevels = (sizeof(Slot) <= 8) ? 3 : (sizeof(Slot) <= 16) ? 2 : 1;
+
+private:
+    Storage m_storage;
+    size_t m_count;
+};
+
+} // namespace static_map
+
+#endif /* eytzinger_hpp */
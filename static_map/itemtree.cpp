@@ -9,13 +9,18 @@
 #include "itemtree.hpp"
 
 #include <cassert>
-#include <utility>
 
 namespace static_map
 {
-StructItem::StructItem(ItemArray& array, const void* data) : m_item(), m_data(data)
+// without the key cache, the five links are all there is of an item
+static_assert(STATIC_MAP_KEY_CACHE || sizeof(StructItem) == (STATIC_MAP_COMPACT_LINKS ? 20 : 5 * sizeof(void*)),
+              "StructItem has grown");
+
+StructItem::StructItem(ItemArray& array, const void* data) : m_arrayItem(), m_treeItem(), m_data()
 {
-    m_item.m_arrayItem.initNull();
+    m_arrayItem.initNull();
+    m_treeItem.initNull();
+    m_data.set(data);
     array.appendItem(*this);
 }
 
@@ -31,17 +36,17 @@ void ItemArray::setDefault(const StructItem& item)
 
 void ItemArray::appendItem(StructItem& item)
 {
-    assert(!item.m_item.m_arrayItem.m_next);
-    assert(!item.m_item.m_arrayItem.m_prev);
+    assert(!item.m_arrayItem.m_next.get());
+    assert(!item.m_arrayItem.m_prev.get());
     if (m_last)
     {
         // the array is not empty
         assert(m_first);
-        assert(!m_last->m_item.m_arrayItem.m_next);
+        assert(!m_last->m_arrayItem.m_next.get());
         // make the last item point to the new item as next
-        m_last->m_item.m_arrayItem.m_next = &item;
+        m_last->m_arrayItem.m_next.set(&item);
         // make the new item point to the last item as prev
-        item.m_item.m_arrayItem.m_prev = m_last;
+        item.m_arrayItem.m_prev.set(m_last);
         // make the new item the last item
         m_last = &item;
     }
@@ -54,68 +59,61 @@ void ItemArray::appendItem(StructItem& item)
         m_first = &item;
         m_last = &item;
     }
+    ++m_count;
 }
 
 void ItemArray::removeItem(StructItem& item)
 {
     if (m_first == &item)
     {
-        m_first = item.m_item.m_arrayItem.m_next;
+        m_first = item.m_arrayItem.m_next.get();
     }
     if (m_last == &item)
     {
-        m_last = item.m_item.m_arrayItem.m_prev;
+        m_last = item.m_arrayItem.m_prev.get();
     }
-    if (item.m_item.m_arrayItem.m_prev)
+    if (item.m_arrayItem.m_prev.get())
     {
-        item.m_item.m_arrayItem.m_prev->m_item.m_arrayItem.m_next = item.m_item.m_arrayItem.m_next;
+        item.m_arrayItem.m_prev.get()->m_arrayItem.m_next.set(item.m_arrayItem.m_next.get());
     }
-    if (item.m_item.m_arrayItem.m_next)
+    if (item.m_arrayItem.m_next.get())
     {
-        item.m_item.m_arrayItem.m_next->m_item.m_arrayItem.m_prev = item.m_item.m_arrayItem.m_prev;
+        item.m_arrayItem.m_next.get()->m_arrayItem.m_prev.set(item.m_arrayItem.m_prev.get());
     }
-    item.m_item.m_arrayItem.initNull();
+    item.m_arrayItem.initNull();
+    assert(m_count > 0);
+    --m_count;
 }
 
-StructItem* ItemArray::getMiddleOf(StructItem* first, StructItem* last)
+void ItemArray::releaseAll()
 {
-    StructItem* fromLeft = first;
-    StructItem* fromRight = last;
-    bool moveUsingLeft = true;
-    while (fromLeft != fromRight)
-    {
-        if (moveUsingLeft)
-        {
-            fromLeft = fromLeft->m_item.m_arrayItem.m_next;
-        }
-        else
-        {
-            fromRight = fromRight->m_item.m_arrayItem.m_prev;
-        }
-        moveUsingLeft = !moveUsingLeft;
-    }
-    assert(fromLeft == fromRight);
-    return fromLeft;
+    m_first = nullptr;
+    m_last = nullptr;
+    m_count = 0;
 }
 
 void ItemArray::swapItems(StructItem* item1, StructItem* item2)
 {
     assert(item1);
     assert(item2);
-    if (item1->m_item.m_arrayItem.m_next == item2)
+    if (item1->m_arrayItem.m_next.get() == item2)
     {
         swapConsecutive(item1, item2);
     }
-    else if (item2->m_item.m_arrayItem.m_next == item1)
+    else if (item2->m_arrayItem.m_next.get() == item1)
     {
         swapConsecutive(item2, item1);
     }
     else
     {
         // have item1's next point to item2's next and vice versa
-        std::swap(item1->m_item.m_arrayItem.m_next, item2->m_item.m_arrayItem.m_next);
+        StructItem* next1 = item1->m_arrayItem.m_next.get();
+        item1->m_arrayItem.m_next.set(item2->m_arrayItem.m_next.get());
+        item2->m_arrayItem.m_next.set(next1);
         // have item1's prev point to item2's prev and vice versa
-        std::swap(item1->m_item.m_arrayItem.m_prev, item2->m_item.m_arrayItem.m_prev);
+        StructItem* prev1 = item1->m_arrayItem.m_prev.get();
+        item1->m_arrayItem.m_prev.set(item2->m_arrayItem.m_prev.get());
+        item2->m_arrayItem.m_prev.set(prev1);
     }
     if (m_first == item1)
     {
@@ -143,27 +141,27 @@ void ItemArray::swapConsecutive(StructItem* item1, StructItem* item2)
 {
     // assert that both are valid and that item1 immediately precedes item2
     assert(item1);
-    assert(item1->m_item.m_arrayItem.m_next == item2);
+    assert(item1->m_arrayItem.m_next.get() == item2);
     assert(item2);
-    assert(item2->m_item.m_arrayItem.m_prev == item1);
+    assert(item2->m_arrayItem.m_prev.get() == item1);
 
     // item1's next is now item2's next
-    StructItem* next = item2->m_item.m_arrayItem.m_next;
-    item1->m_item.m_arrayItem.m_next = next;
+    StructItem* next = item2->m_arrayItem.m_next.get();
+    item1->m_arrayItem.m_next.set(next);
     if (next)
     {
-        next->m_item.m_arrayItem.m_prev = item1;
+        next->m_arrayItem.m_prev.set(item1);
     }
     // item2's prev is now item1's prev
-    StructItem* prev = item1->m_item.m_arrayItem.m_prev;
-    item2->m_item.m_arrayItem.m_prev = prev;
+    StructItem* prev = item1->m_arrayItem.m_prev.get();
+    item2->m_arrayItem.m_prev.set(prev);
     if (prev)
     {
-        prev->m_item.m_arrayItem.m_next = item2;
+        prev->m_arrayItem.m_next.set(item2);
     }
     // now make them point to each other, item2, then item 1
-    item1->m_item.m_arrayItem.m_prev = item2;
-    item2->m_item.m_arrayItem.m_next = item1;
+    item1->m_arrayItem.m_prev.set(item2);
+    item2->m_arrayItem.m_next.set(item1);
 }
 
 //
@@ -176,69 +174,149 @@ void ItemTree::constructFrom(ItemArray& sortedArray)
     assert(!m_top);
     assert(!m_first);
     assert(!m_last);
+    assert(!m_count);
+    StructItem* top = nullptr;
     // if the array is empty, then the tree will be
     if (!sortedArray.isEmpty())
     {
-        StructItem* left = sortedArray.getFirst();
-        assert(left);
-        StructItem* right = sortedArray.getLast();
-        assert(right);
-        StructItem* mid = sortedArray.getMiddleOf(left, right);
-        assert(mid);
-
-        recursiveConstruct(left, mid, right, sortedArray);
-        m_top = mid;
-        m_first = getLeftmostChildOf(m_top);
-        m_last = getRightmostChildOf(m_top);
+        StructItem* next = sortedArray.getFirst();
+        top = recursiveConstruct(next, sortedArray.getCount());
+        // every item should have been used
+        assert(!next);
+        assert(top);
     }
-    m_default = sortedArray.getDefault();
+    finishConstruct(sortedArray, top);
 }
 
-// find the middle of each of two ranges, left to mid and mid to right
-// call the recursiveConstruct on each of those two ranges until the
-// ranges cnverge into a single node
-void ItemTree::recursiveConstruct(StructItem* left, StructItem* mid, StructItem* right, ItemArray& sortedArray)
+void ItemTree::constructFrom(ItemArray& sortedArray, TItemWeight weightOf, const void* context)
 {
-    assert(left);
-    assert(mid);
-    assert(right);
-
-    StructItem* newMidLeft = nullptr;
-    StructItem* newMidRight = nullptr;
-    bool hasLeft = (left != mid);
-    bool hasRight = (mid != right);
-
-    if (hasLeft)
+    assert(weightOf);
+    // only construct if not already constructed
+    assert(!m_top);
+    assert(!m_first);
+    assert(!m_last);
+    assert(!m_count);
+    uint64_t weight = 0;
+    for (StructItem* item = sortedArray.getFirst(); item; item = sortedArray.getNext(item))
     {
-        StructItem* innerLeft = sortedArray.getPrev(mid);
-        newMidLeft = sortedArray.getMiddleOf(left, innerLeft);
-        recursiveConstruct(left, newMidLeft, innerLeft, sortedArray);
+        weight += weightOf(item, context);
     }
-    if (hasRight)
+    StructItem* top = weightedConstruct(sortedArray.getFirst(), sortedArray.getLast(), sortedArray.getCount(), weight,
+                                        weightOf, context);
+    finishConstruct(sortedArray, top);
+}
+
+void ItemTree::finishConstruct(ItemArray& sortedArray, StructItem* top)
+{
+    if (top)
     {
-        StructItem* innerRight = sortedArray.getNext(mid);
-        newMidRight = sortedArray.getMiddleOf(innerRight, right);
-        recursiveConstruct(innerRight, newMidRight, right, sortedArray);
+        // the items keep their list links, so the ends of the list are
+        // the ends of the tree
+        m_top = top;
+        m_count = sortedArray.getCount();
+        m_first = sortedArray.getFirst();
+        m_last = sortedArray.getLast();
+        assert(m_first == getLeftmostChildOf(m_top));
+        assert(m_last == getRightmostChildOf(m_top));
     }
+    m_default = sortedArray.getDefault();
+    m_keySkip = sortedArray.getKeySkip();
+    m_hasRepeats = sortedArray.hasRepeats();
+    // the items now belong to the tree
+    sortedArray.releaseAll();
+}
+
+// build the left subtree out of the first half of the items, the next item
+// is the middle, and the right subtree gets what is left.  the list links
+// are left alone, so that they can be used to step through the tree.
+StructItem* ItemTree::recursiveConstruct(StructItem*& next, size_t count)
+{
+    if (count == 0)
+        return nullptr;
 
-    sortedArray.removeItem(*mid);
-    mid->m_item.m_treeItem.initNull();
+    const size_t leftCount = count / 2;
+    StructItem* left = recursiveConstruct(next, leftCount);
 
-    if (hasLeft)
+    StructItem* mid = next;
+    assert(mid);
+    next = mid->m_arrayItem.m_next.get();
+
+    StructItem* right = recursiveConstruct(next, count - leftCount - 1);
+
+    mid->m_treeItem.m_left.set(left);
+    mid->m_treeItem.m_right.set(right);
+    return mid;
+}
+
+// the root is the first item where it and the items before it weigh at
+// least as much as the items after it, which is also the last item where
+// the items after it weigh no more than the rest.  it is looked for from
+// both ends at once, so finding it takes steps in proportion to the size of
+// the smaller subtree, and the whole tree takes O(n log n) time however the
+// weights are skewed.  when the items weigh nothing, there is nothing to go
+// by, so they are balanced.
+StructItem* ItemTree::weightedConstruct(StructItem* first, StructItem* last, size_t count, uint64_t weight,
+                                        TItemWeight weightOf, const void* context)
+{
+    if (count == 0)
+        return nullptr;
+    if (weight == 0)
     {
-        StructItem* newLeft = newMidLeft ? newMidLeft : left;
-        assert(newLeft);
-        mid->m_item.m_treeItem.m_left = newLeft;
-        newLeft->m_item.m_treeItem.m_parent = mid;
+        StructItem* next = first;
+        return recursiveConstruct(next, count);
     }
 
-    if (hasRight)
+    // from the left, the weight before the item, and from the right, the
+    // weight after it
+    StructItem* fromLeft = first;
+    size_t leftCount = 0;
+    uint64_t leftWeight = 0;
+    uint64_t fromLeftWeight = weightOf(fromLeft, context);
+    StructItem* fromRight = last;
+    size_t rightCount = 0;
+    uint64_t rightWeight = 0;
+    StructItem* root = nullptr;
+    uint64_t rootWeight = 0;
+    while (!root)
     {
-        StructItem* newRight = newMidRight ? newMidRight : right;
-        assert(newRight);
-        mid->m_item.m_treeItem.m_right = newRight;
-        newRight->m_item.m_treeItem.m_parent = mid;
+        if (leftWeight + fromLeftWeight >= weight - leftWeight - fromLeftWeight)
+        {
+            root = fromLeft;
+            rootWeight = fromLeftWeight;
+            rightCount = count - leftCount - 1;
+            rightWeight = weight - leftWeight - rootWeight;
+            break;
+        }
+        leftWeight += fromLeftWeight;
+        ++leftCount;
+        fromLeft = fromLeft->m_arrayItem.m_next.get();
+        assert(fromLeft && leftCount < count);
+        fromLeftWeight = weightOf(fromLeft, context);
+
+        // the item before fromRight is the root too if the weight after it
+        // is still no more than the rest
+        const uint64_t fromRightWeight = weightOf(fromRight, context);
+        if (rightWeight + fromRightWeight > weight - rightWeight - fromRightWeight)
+        {
+            root = fromRight;
+            rootWeight = fromRightWeight;
+            leftCount = count - rightCount - 1;
+            leftWeight = weight - rightWeight - rootWeight;
+            break;
+        }
+        rightWeight += fromRightWeight;
+        ++rightCount;
+        fromRight = fromRight->m_arrayItem.m_prev.get();
+        assert(fromRight && rightCount < count);
     }
+
+    StructItem* left = weightedConstruct(first, root->m_arrayItem.m_prev.get(), leftCount, leftWeight, weightOf,
+                                         context);
+    StructItem* right = weightedConstruct(root->m_arrayItem.m_next.get(), last, rightCount, rightWeight, weightOf,
+                                          context);
+    root->m_treeItem.m_left.set(left);
+    root->m_treeItem.m_right.set(right);
+    return root;
 }
 
 // follow the left child until there is no more
@@ -249,7 +327,7 @@ const StructItem* ItemTree::getLeftmostChildOf(const StructItem* item) const
     while (left)
     {
         leftmost = left;
-        left = left->m_item.m_treeItem.m_left;
+        left = left->m_treeItem.m_left.get();
     }
     return leftmost;
 }
@@ -262,41 +340,9 @@ const StructItem* ItemTree::getRightmostChildOf(const StructItem* item) const
     while (right)
     {
         rightmost = right;
-        right = right->m_item.m_treeItem.m_right;
+        right = right->m_treeItem.m_right.get();
     }
     return rightmost;
 }
 
-const StructItem* ItemTree::getNext(const StructItem* item) const
-{
-    // next is the leftmost of the right child
-    assert(item);
-    const StructItem* right = item->m_item.m_treeItem.m_right;
-    const StructItem* next = getLeftmostChildOf(right);
-    // if there is no right child, then get the parent if this is the left child
-    if (!next)
-    {
-        const StructItem* parent = item->m_item.m_treeItem.m_parent;
-        if (parent && parent->m_item.m_treeItem.m_left == item)
-            next = parent;
-    }
-    return next;
-}
-
-const StructItem* ItemTree::getPrev(const StructItem* item) const
-{
-    // prev is the rightmost of the left child
-    assert(item);
-    const StructItem* left = item->m_item.m_treeItem.m_left;
-    const StructItem* prev = getRightmostChildOf(left);
-    // if there is no left child, then get the parent if this is the right child
-    if (!prev)
-    {
-        const StructItem* parent = item->m_item.m_treeItem.m_parent;
-        if (parent && parent->m_item.m_treeItem.m_right == item)
-            prev = parent;
-    }
-    return prev;
-}
-
 } // namespace static_map
@@ -10,60 +10,175 @@
 #define itemtree_hpp
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+// hint that the memory at the address will be read soon
+#if defined(__GNUC__) || defined(__clang__)
+#define STATIC_MAP_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define STATIC_MAP_PREFETCH(addr) ((void) (addr))
+#endif
+
+// define it as 1 to keep a copy of (a prefix of) the key in each tree node
+// for the keys that KeyCache supports, so that a search does not have to go
+// to the item for its key.  it costs 8 bytes in every item of every map,
+// whether or not its key is one that KeyCache supports, so it is off unless
+// the maps that are searched most have small keys
+#ifndef STATIC_MAP_KEY_CACHE
+#define STATIC_MAP_KEY_CACHE 0
+#endif
+
+// store the links between items as 32 bit distances instead of pointers,
+// which makes each item 20 bytes instead of 40 on a 64 bit machine.  with
+// the key cache as well it is 32 bytes instead of 48, since the cache keeps
+// it 8 byte aligned.  every item has to be within 2GB of the items and data
+// that it links to, which is true of static items and data in the same
+// image, but may not be of items on the heap
+#ifndef STATIC_MAP_COMPACT_LINKS
+#define STATIC_MAP_COMPACT_LINKS 0
+#endif
 
 namespace static_map
 {
 
+template<typename T>
+class ItemLink;
 struct ArrayItem;
 struct TreeItem;
 class StructItem;
 class ItemArray;
 class ItemTree;
 
+//
+// ItemLink: a link from an item to another item or to its data.  It is a
+// pointer, or with STATIC_MAP_COMPACT_LINKS, the distance from the link to
+// what it points to.  A distance only makes sense where the link is, so
+// links cannot be copied, only read with get and written with set.
+//
+
+#if STATIC_MAP_COMPACT_LINKS
+
+template<typename T>
+class ItemLink
+{
+public:
+    ItemLink() : m_offset(0) {}
+    ~ItemLink() = default;
+
+private:
+    ItemLink(const ItemLink&) = delete;
+    ItemLink& operator=(const ItemLink&) = delete;
+
+public:
+    // nothing can be at the link itself, so 0 is nullptr
+    T* get() const
+    {
+        return m_offset ? reinterpret_cast<T*>(reinterpret_cast<intptr_t>(this) + m_offset) : nullptr;
+    }
+    void set(T* target)
+    {
+        const intptr_t offset = target ? reinterpret_cast<intptr_t>(target) - reinterpret_cast<intptr_t>(this) : 0;
+        // the target must be within reach
+        assert(offset == static_cast<int32_t>(offset));
+        m_offset = static_cast<int32_t>(offset);
+    }
+
+private:
+    int32_t m_offset;
+};
+
+#else
+
+template<typename T>
+class ItemLink
+{
+public:
+    ItemLink() : m_target(nullptr) {}
+    ~ItemLink() = default;
+
+private:
+    ItemLink(const ItemLink&) = delete;
+    ItemLink& operator=(const ItemLink&) = delete;
+
+public:
+    T* get() const { return m_target; }
+    void set(T* target) { m_target = target; }
+
+private:
+    T* m_target;
+};
+
+#endif
+
 //
 // ArrayItem: a doubly linked node
 //
 
 struct ArrayItem
 {
-    StructItem* m_prev;
-    StructItem* m_next;
+    ItemLink<StructItem> m_prev;
+    ItemLink<StructItem> m_next;
 
     // zero out the links
-    // this cannot be a constructor because this will be part of a union
     void initNull()
     {
-        m_prev = nullptr;
-        m_next = nullptr;
+        m_prev.set(nullptr);
+        m_next.set(nullptr);
     }
 };
 
 //
-// TreeItem: a binary tree node
+// TreeItem: a binary tree node.  There is no link to the parent since
+// stepping through the tree uses the list links instead
 //
 
 struct TreeItem
 {
-    StructItem* m_parent;
-    StructItem* m_left;
-    StructItem* m_right;
+    ItemLink<StructItem> m_left;
+    ItemLink<StructItem> m_right;
+#if STATIC_MAP_KEY_CACHE
+    // the KeyCache prefix of the key of the item
+    uint64_t m_keyCache;
+#endif
 
     // zero out the links
-    // this cannot be a constructor because this will be part of a union
     void initNull()
     {
-        m_parent = nullptr;
-        m_left = nullptr;
-        m_right = nullptr;
+        m_left.set(nullptr);
+        m_right.set(nullptr);
+    }
+
+    // the key prefix, which is always 0 when the items do not keep one
+    uint64_t getKeyCache() const
+    {
+#if STATIC_MAP_KEY_CACHE
+        return m_keyCache;
+#else
+        return 0;
+#endif
+    }
+    void setKeyCache(uint64_t keyCache)
+    {
+#if STATIC_MAP_KEY_CACHE
+        m_keyCache = keyCache;
+#else
+        (void) keyCache;
+#endif
     }
 };
 
 //
-// StructItem: map item base class.  Contains a union between
-// the linked list node and binary tree node.  This item will act as a
-// linked list during its creation while it is pushed into the Builder.  It
-// will then be transformed into a balanced binary tree once the Map that
-// consumes the Builder is created.
+// StructItem: map item base class.  Contains both the linked list node and
+// the binary tree node.  This item will act as a linked list during its
+// creation while it is pushed into the Builder.  It will then be transformed
+// into a balanced binary tree once the Map that consumes the Builder is
+// created.  The list has been sorted by then, so its links are kept as the
+// successor and predecessor of each item in the tree, which makes stepping
+// through the tree O(1).
 //
 class StructItem
 {
@@ -77,21 +192,18 @@ protected:
     ~StructItem() = default;
 
 protected:
-    const void* dataPtr() const { return m_data; }
+    const void* dataPtr() const { return m_data.get(); }
 
 private:
     StructItem(const StructItem&) = delete;
     StructItem& operator=(const StructItem&) = delete;
 
 private:
-    // union of node types
-    typedef union {
-        ArrayItem m_arrayItem;
-        TreeItem m_treeItem;
-    } Item;
-
-    Item m_item;
-    const void* m_data;
+    // the list links, which are the order of the items in the tree
+    ArrayItem m_arrayItem;
+    // the tree links
+    TreeItem m_treeItem;
+    ItemLink<const void> m_data;
 };
 
 //
@@ -101,8 +213,18 @@ private:
 class ItemArray
 {
 public:
-    // construct it as empty
-    ItemArray() : m_first(nullptr), m_last(nullptr), m_default(nullptr) {}
+    // construct it as empty, at compile time for a static builder so that
+    // items in other files can be added to it before it would otherwise be
+    // constructed
+    constexpr ItemArray() :
+        m_first(nullptr),
+        m_last(nullptr),
+        m_default(nullptr),
+        m_count(0),
+        m_keySkip(0),
+        m_hasRepeats(false)
+    {
+    }
     // destroy it
     ~ItemArray() = default;
 
@@ -113,6 +235,8 @@ private:
 public:
     // returns true if nothing has been added
     bool isEmpty() const { return !m_first; }
+    // returns the number of items in O(1) time
+    size_t getCount() const { return m_count; }
 
 public:
     // sets the default item
@@ -122,6 +246,9 @@ public:
     // removes the item and makes the left and right items
     // point to each other as necessary in O(1) time
     void removeItem(StructItem& item);
+    // forgets all of the items in O(1) time without touching them, used
+    // when the items have been taken over by something else
+    void releaseAll();
 
 public:
     // gets the first element in O(1) time, returns nullptr if empty
@@ -131,24 +258,38 @@ public:
     StructItem* getNext(StructItem* item)
     {
         assert(item);
-        return item->m_item.m_arrayItem.m_next;
+        return item->m_arrayItem.m_next.get();
     }
     // gets the prev element in O(1) time, returns nullptr if at first
     // will fail if called with nullptr
     StructItem* getPrev(StructItem* item)
     {
         assert(item);
-        return item->m_item.m_arrayItem.m_prev;
+        return item->m_arrayItem.m_prev.get();
     }
     // gets the last element in O(1) time, returns nullptr if empty
     StructItem* getLast() { return m_last; }
-    // gets the middle element of the range given, in O(n) time,
-    // first and last must be on same sequence, and be not nullptr
-    // and first has to be before last or this will fail
-    // if distance between elements is odd, it can return the before
-    // or after the middle.  will return either first or last if
-    // nodes are consecutive.  will return first if first == last
-    StructItem* getMiddleOf(StructItem* first, StructItem* last);
+    // sets the key prefix kept in the item, does nothing if there is no
+    // room for it
+    void setKeyCache(StructItem* item, uint64_t keyCache)
+    {
+        assert(item);
+        item->m_treeItem.setKeyCache(keyCache);
+    }
+    // gets the key prefix kept in the item in O(1) time
+    uint64_t getKeyCache(const StructItem* item) const
+    {
+        assert(item);
+        return item->m_treeItem.getKeyCache();
+    }
+    // sets the length of the start that all of the keys share, which the
+    // key prefixes leave out
+    void setKeySkip(size_t keySkip) { m_keySkip = keySkip; }
+    size_t getKeySkip() const { return m_keySkip; }
+    // sets whether some items were kept that have the same key as the item
+    // before them, so that searches must find the first one
+    void setHasRepeats(bool hasRepeats) { m_hasRepeats = hasRepeats; }
+    bool hasRepeats() const { return m_hasRepeats; }
     //
     const StructItem* getDefault() const { return m_default; }
     
@@ -158,11 +299,28 @@ public:
     // both items must not be null and must be in list
     // item1 and item2 can be in any order
     void swapItems(StructItem* item1, StructItem* item2);
+    // stable sort of the list in O(n log n) time by relinking the items,
+    // or O(n) time if the items are already in order, requires no
+    // allocation.  less is called as less(lhs, rhs) with two
+    // const StructItem* and must return true if lhs goes before rhs
+    template<typename TLess>
+    void sortItems(TLess less);
 
 private:
+    // returns true if no item goes before the item ahead of it
+    template<typename TLess>
+    bool isSorted(TLess& less) const;
     // implementation function for swap when the items are consecutive
     // requires that item1 immediately precede item2
     void swapConsecutive(StructItem* item1, StructItem* item2);
+    // merges two sorted runs linked only through next and ending in nullptr
+    // items of left win ties so that the merge is stable
+    template<typename TLess>
+    static StructItem* mergeRuns(StructItem* left, StructItem* right, TLess& less);
+
+private:
+    // enough runs to hold 2^64 items, which is more than can be addressed
+    static const int s_maxRuns = 64;
 
 private:
     // the first item in the list
@@ -171,29 +329,165 @@ private:
     StructItem* m_last;
     //default item
     const StructItem* m_default;
+    // the number of items in the list
+    size_t m_count;
+    // the length of the start of the keys left out of the key prefixes
+    size_t m_keySkip;
+    // whether equal keys were kept
+    bool m_hasRepeats;
 };
 
+// bottom-up merge sort: each item is merged in as a run of one.  runs[i]
+// is either empty or holds a sorted run of 2^i items, and whenever two runs of
+// the same size meet they are merged and carried up like a binary counter.
+// only the next links are used while sorting, the prev links are fixed up
+// in a single pass at the end.
+template<typename TLess>
+void ItemArray::sortItems(TLess less)
+{
+    // items are mostly declared in order, which is found in one pass
+    if (isSorted(less))
+        return;
+
+    StructItem* runs[s_maxRuns] = {};
+    StructItem* item = m_first;
+    while (item)
+    {
+        StructItem* next = item->m_arrayItem.m_next.get();
+        item->m_arrayItem.m_next.set(nullptr);
+        // runs[i] always holds items that came before carry
+        StructItem* carry = item;
+        int i = 0;
+        while (runs[i])
+        {
+            carry = mergeRuns(runs[i], carry, less);
+            runs[i] = nullptr;
+            ++i;
+        }
+        assert(i < s_maxRuns);
+        runs[i] = carry;
+        item = next;
+    }
+
+    // the bigger runs hold the earlier items, so merge from small to big
+    StructItem* sorted = nullptr;
+    for (int i = 0; i < s_maxRuns; ++i)
+    {
+        if (runs[i])
+        {
+            sorted = sorted ? mergeRuns(runs[i], sorted, less) : runs[i];
+        }
+    }
+
+    // restore the prev links and the ends of the list
+    StructItem* prev = nullptr;
+    m_first = sorted;
+    for (item = sorted; item; item = item->m_arrayItem.m_next.get())
+    {
+        item->m_arrayItem.m_prev.set(prev);
+        prev = item;
+    }
+    m_last = prev;
+}
+
+template<typename TLess>
+bool ItemArray::isSorted(TLess& less) const
+{
+    if (!m_first)
+        return true;
+    const StructItem* prev = m_first;
+    for (const StructItem* item = prev->m_arrayItem.m_next.get(); item; item = item->m_arrayItem.m_next.get())
+    {
+        if (less(item, prev))
+            return false;
+        prev = item;
+    }
+    return true;
+}
+
+template<typename TLess>
+StructItem* ItemArray::mergeRuns(StructItem* left, StructItem* right, TLess& less)
+{
+    StructItem* head = nullptr;
+    StructItem* tail = nullptr;
+    while (left && right)
+    {
+        // only take from the right if it is strictly less
+        StructItem* taken;
+        if (less(static_cast<const StructItem*>(right), static_cast<const StructItem*>(left)))
+        {
+            taken = right;
+            right = right->m_arrayItem.m_next.get();
+        }
+        else
+        {
+            taken = left;
+            left = left->m_arrayItem.m_next.get();
+        }
+        if (tail)
+            tail->m_arrayItem.m_next.set(taken);
+        else
+            head = taken;
+        tail = taken;
+    }
+    StructItem* rest = left ? left : right;
+    if (tail)
+        tail->m_arrayItem.m_next.set(rest);
+    else
+        head = rest;
+    return head;
+}
+
 //
 // ItemTree: a binary tree of StructItem
 //
 
 class ItemTree
 {
+public:
+    // gets how often an item is looked up, for a weighted tree
+    typedef uint64_t (*TItemWeight)(const StructItem* item, const void* context);
+
 public:
     // construct the tree as empty
-    ItemTree() : m_top(nullptr), m_first(nullptr), m_last(nullptr), m_default(nullptr) {}
+    ItemTree() :
+        m_top(nullptr),
+        m_first(nullptr),
+        m_last(nullptr),
+        m_default(nullptr),
+        m_count(0),
+        m_keySkip(0),
+        m_hasRepeats(false)
+    {
+    }
     // destroy the object
     ~ItemTree() = default;
 
 public:
-    // construct a balanced tree from the sorted array
-    // we will find the middle, make that the top and then
-    // recurse the left and right halves to make sub trees
+    // construct a balanced tree from the sorted array in O(n) time
+    // the items are consumed in order in a single pass, each subtree
+    // taking as many items as its size requires, so the middle never
+    // has to be searched for
     void constructFrom(ItemArray& sortedArray);
+    // construct a tree from the sorted array that puts the items that weigh
+    // the most nearest the top, so that the lookups of items that are
+    // looked up more often take fewer steps.  each root is the item that
+    // splits the weight of its subtree in half (Mehlhorn's rule), which
+    // keeps the expected number of steps near the best possible.  items
+    // that weigh nothing are balanced.  this takes O(n log n) time however
+    // the weights are skewed
+    void constructFrom(ItemArray& sortedArray, TItemWeight weightOf, const void* context);
 
 private:
-    // the implementation for the construction
-    static void recursiveConstruct(StructItem* left, StructItem* mid, StructItem* right, ItemArray& sortedArray);
+    // the implementation for the construction, builds a subtree from the
+    // next count items starting at next and advances next past them
+    static StructItem* recursiveConstruct(StructItem*& next, size_t count);
+    // the same for a weighted tree, from the count items first to last
+    // that weigh weight in all
+    static StructItem* weightedConstruct(StructItem* first, StructItem* last, size_t count, uint64_t weight,
+                                         TItemWeight weightOf, const void* context);
+    // the part of constructFrom after the top is built
+    void finishConstruct(ItemArray& sortedArray, StructItem* top);
 
 private:
     ItemTree(const ItemTree&) = delete;
@@ -209,21 +503,31 @@ public:
     // get the first element in O(1) time
     // returns nullptr if empty
     const StructItem* getFirst() const { return m_first; }
-    // get the next element in O(log n) time or better
+    // get the next element in O(1) time
     // return nullptr if already at last
     // do not call with nullptr
-    const StructItem* getNext(const StructItem* item) const;
-    // get the prev element in O(log n) time or better
+    const StructItem* getNext(const StructItem* item) const
+    {
+        assert(item);
+        return item->m_arrayItem.m_next.get();
+    }
+    // get the prev element in O(1) time
     // return nullptr if already at first
     // do not call with nullptr
-    const StructItem* getPrev(const StructItem* item) const;
+    const StructItem* getPrev(const StructItem* item) const
+    {
+        assert(item);
+        return item->m_arrayItem.m_prev.get();
+    }
     // get the last element in O(1) time
     // returns nullptr if empty
     const StructItem* getLast() const { return m_last; }
 
 public:
     const StructItem* getDefault() const { return m_default; }
-    
+    // get the number of items in O(1) time
+    size_t getCount() const { return m_count; }
+
 public:
     // gets the middle element in O(1) time
     // returns nullptr if empty
@@ -234,7 +538,7 @@ public:
     const StructItem* getTrySmaller(const StructItem* item) const
     {
         assert(item);
-        return item->m_item.m_treeItem.m_left;
+        return item->m_treeItem.m_left.get();
     }
 
     // gets the next larger try element in O(1) time
@@ -243,14 +547,30 @@ public:
     const StructItem* getTryLarger(const StructItem* item) const
     {
         assert(item);
-        return item->m_item.m_treeItem.m_right;
+        return item->m_treeItem.m_right.get();
+    }
+
+    // gets the key prefix kept in the item in O(1) time
+    // do not call with nullptr
+    uint64_t getKeyCache(const StructItem* item) const
+    {
+        assert(item);
+        return item->m_treeItem.getKeyCache();
     }
+    // gets the length of the start of the keys left out of the prefixes
+    size_t getKeySkip() const { return m_keySkip; }
+    // returns true if some items have the same key, which are next to each
+    // other in the order they were added
+    bool hasRepeats() const { return m_hasRepeats; }
 
 private:
     const StructItem* m_top;
     const StructItem* m_first;
     const StructItem* m_last;
     const StructItem* m_default;
+    size_t m_count;
+    size_t m_keySkip;
+    bool m_hasRepeats;
 };
 
 //
@@ -276,6 +596,96 @@ private:
     static const TData& toData(const void* ptr) { return *reinterpret_cast<const TData*>(ptr); }
 };
 
+//
+// KeyCache: says whether a map can keep a copy of its keys in the tree
+// nodes, and makes the 64 bit prefix that is kept.  The prefixes must be in
+// the same order as the keys under TKeySort.  When isWhole(prefix), the
+// prefix is all of the key, so equal prefixes mean equal keys; otherwise
+// keys with equal prefixes are compared in full.  isExact says that every
+// prefix is whole.  For keys that are sequences, like strings, the start
+// that all of the keys of a map share (as found by sharedLength) can be
+// skipped, and the prefix made from what comes after it.  Integers and
+// enums of up to 64 bits ordered by their value are cached exactly, and C
+// strings ordered by StrLess keep 8 characters (see strref.hpp).
+// Specialize it for other keys as needed.
+//
+template<typename TKey, typename TKeySort, typename TEnable = void>
+struct KeyCache
+{
+    static const bool isCached = false;
+    static const bool isExact = false;
+    static uint64_t prefixOf(const TKey&, size_t) { return 0; }
+    static size_t sharedLength(const TKey&, const TKey&, size_t) { return 0; }
+    static bool isWhole(uint64_t) { return false; }
+};
+
+// the bits of an integer or enum, flipping the sign bit of signed values so
+// that they are in the same order as unsigned values
+template<typename TKey>
+struct KeyCacheValue
+{
+    typedef typename std::conditional<std::is_enum<TKey>::value, std::underlying_type<TKey>,
+                                      std::common_type<TKey>>::type::type TValue;
+
+    static uint64_t prefixOf(TValue value)
+    {
+        return std::is_signed<TValue>::value ? static_cast<uint64_t>(static_cast<int64_t>(value)) ^ (1ULL << 63)
+                                             : static_cast<uint64_t>(value);
+    }
+};
+
+template<typename TKey>
+struct KeyCache<TKey, std::less<TKey>,
+                typename std::enable_if<(std::is_integral<TKey>::value || std::is_enum<TKey>::value) &&
+                                        sizeof(TKey) <= sizeof(uint64_t)>::type>
+{
+    static const bool isCached = true;
+    static const bool isExact = true;
+    static uint64_t prefixOf(const TKey& key, size_t)
+    {
+        return KeyCacheValue<TKey>::prefixOf(static_cast<typename KeyCacheValue<TKey>::TValue>(key));
+    }
+    static size_t sharedLength(const TKey&, const TKey&, size_t) { return 0; }
+    static bool isWhole(uint64_t) { return true; }
+};
+
+// enums that are ordered as ints, like the values of Enum
+template<typename TKey>
+struct KeyCache<TKey, std::less<int>, typename std::enable_if<std::is_enum<TKey>::value>::type>
+{
+    static const bool isCached = true;
+    static const bool isExact = true;
+    static uint64_t prefixOf(const TKey& key, size_t) { return KeyCacheValue<int>::prefixOf(static_cast<int>(key)); }
+    static size_t sharedLength(const TKey&, const TKey&, size_t) { return 0; }
+    static bool isWhole(uint64_t) { return true; }
+};
+
+//
+// IsTransparent: true if TKeySort has is_transparent, like StrLess, which
+// means it can compare the keys with other types of keys.  The maps can then
+// be searched with those types, as with the std::map of C++14.
+//
+template<typename T>
+struct MakeVoid
+{
+    typedef void type;
+};
+
+template<typename TKeySort, typename TEnable = void>
+struct IsTransparent : std::false_type
+{
+};
+
+template<typename TKeySort>
+struct IsTransparent<TKeySort, typename MakeVoid<typename TKeySort::is_transparent>::type> : std::true_type
+{
+};
+
+// used as a template parameter of a function so that it only exists when
+// a search key of type TOther can be used in place of a TKey
+template<typename TKeySort, typename TOther>
+using EnableIfTransparent = typename std::enable_if<IsTransparent<TKeySort>::value, TOther>::type;
+
 //
 // TreeUtil: utility functions using the key and its compare function
 // There is a function for sorting an array in place using the TKey and
@@ -295,60 +705,168 @@ class TreeFuncs
 {
 private:
     typedef StructItemT<TData> TStructItem;
+    typedef KeyCache<TKey, TKeySort> TKeyCache;
+
+    // whether the items hold the prefixes of their keys
+    static const bool s_useKeyCache = STATIC_MAP_KEY_CACHE && TKeyCache::isCached;
+
+private:
+    // orders two items by their keys, using the prefixes of the keys when
+    // they are enough to tell
+    class ItemLess
+    {
+    public:
+        explicit ItemLess(const ItemArray& array) : m_array(&array) {}
+
+    public:
+        bool operator()(const StructItem* lhs, const StructItem* rhs) const
+        {
+            if (s_useKeyCache)
+            {
+                const uint64_t lprefix = m_array->getKeyCache(lhs);
+                const uint64_t rprefix = m_array->getKeyCache(rhs);
+                if (lprefix != rprefix)
+                    return lprefix < rprefix;
+                if (TKeyCache::isWhole(lprefix))
+                    return false;
+            }
+            TKeySort compare;
+            return compare(keyOf(lhs), keyOf(rhs));
+        }
+
+    private:
+        const ItemArray* m_array;
+    };
+
+    // orders two items by their keys alone, for items that are not in the
+    // array that their prefixes were made for
+    class KeyLess
+    {
+    public:
+        bool operator()(const StructItem* lhs, const StructItem* rhs) const
+        {
+            TKeySort compare;
+            return compare(keyOf(lhs), keyOf(rhs));
+        }
+    };
+
+public:
+    // the most searches that findManyInTree and the findMany of an index
+    // take at once
+    static const size_t s_batchSize = 32;
 
 public:
-    // does an inplace  bubble sort (not very efficient) that requires no
-    // allocation
+    // does an inplace stable merge sort in O(n log n) time that requires no
+    // allocation.  the prefixes of the keys are put in the items first, so
+    // that the sort and the searches of the tree can use them
     static void sortInPlace(ItemArray& array)
     {
-        bool mustContinue = true;
-        while (mustContinue)
+        if (s_useKeyCache)
         {
-            // during each pass, go from left to right
-            mustContinue = false;
-            StructItem* item = array.getFirst();
-            while (item)
+            const size_t skip = sharedLength(array);
+            array.setKeySkip(skip);
+            for (StructItem* item = array.getFirst(); item; item = array.getNext(item))
             {
-                const TData& l = static_cast<TStructItem*>(item)->data();
-                StructItem* next = array.getNext(item);
-                StructItem* inc = next;
-                if (next)
+                array.setKeyCache(item, TKeyCache::prefixOf(keyOf(item), skip));
+            }
+        }
+        array.sortItems(ItemLess(array));
+    }
+
+    // goes over the sorted items in O(n) time and calls
+    // onDuplicate(kept, duplicate) with the data of each item that has the
+    // same key as an item before it, where kept is the first item with the
+    // key.  the duplicate is removed from the array if it returns true, and
+    // put at the end of dropped if it is given.  if any are kept, the array
+    // is marked as having repeats.  returns the number of duplicates found
+    template<typename TOnDuplicate>
+    static size_t removeDuplicates(ItemArray& array, const TOnDuplicate& onDuplicate, ItemArray* dropped = nullptr)
+    {
+        ItemLess less(array);
+        size_t found = 0;
+        bool hasRepeats = false;
+        StructItem* kept = array.getFirst();
+        StructItem* item = kept ? array.getNext(kept) : nullptr;
+        while (item)
+        {
+            StructItem* next = array.getNext(item);
+            // sorted, so the items are the same unless kept goes first
+            if (less(kept, item))
+            {
+                kept = item;
+            }
+            else
+            {
+                ++found;
+                if (onDuplicate(dataOf(kept), dataOf(item)))
                 {
-                    // compare consecutive elements
-                    const TData& r = static_cast<TStructItem*>(next)->data();
-                    const TKey& lkey = TKeyGet::key(l);
-                    const TKey& rkey = TKeyGet::key(r);
-                    TKeySort compare;
-                    bool less = compare(rkey, lkey);
-                    if (less)
-                    {
-                        // switch them because they were out of order
-                        array.swapItems(item, next);
-                        // indicate that this cant be last pass
-                        mustContinue = true;
-                        inc = item;
-                    }
+                    array.removeItem(*item);
+                    if (dropped)
+                        dropped->appendItem(*item);
                 }
-                item = inc;
+                else
+                    hasRepeats = true;
             }
+            item = next;
         }
+        array.setHasRepeats(hasRepeats);
+        return found;
     }
 
-    // finds the key in O(log n) time if it exists
+    // removes the items of the sorted array that have the same data as one
+    // of the dropped items, which were removed from the array of another key
+    // of the same data, so that every key of a map has the same items.  the
+    // dropped items are sorted by the key of this array first, and then
+    // both are gone through together in O(n + d log d) time
+    static void removeDropped(ItemArray& array, ItemArray& dropped)
+    {
+        if (dropped.isEmpty())
+            return;
+        TKeySort compare;
+        dropped.sortItems(KeyLess());
+        StructItem* drop = dropped.getFirst();
+        StructItem* item = array.getFirst();
+        while (item && drop)
+        {
+            StructItem* next = array.getNext(item);
+            const TKey& key = keyOf(item);
+            while (drop && compare(keyOf(drop), key))
+                drop = dropped.getNext(drop);
+            // look through the dropped items with the same key
+            for (StructItem* same = drop; same && !compare(key, keyOf(same)); same = dropped.getNext(same))
+            {
+                if (&dataOf(same) == &dataOf(item))
+                {
+                    array.removeItem(*item);
+                    break;
+                }
+            }
+            item = next;
+        }
+    }
+
+    // finds the key in O(log n) time if it exists, and if the tree has
+    // repeats, the first item with the key
     // returns nullptr if not found
     static const StructItem* findInTree(const ItemTree& tree, const TKey& key)
     {
+        size_t depth = 0;
+        return findInTree(tree, key, depth);
+    }
+
+    // the same, also giving the number of items that the search looked at
+    static const StructItem* findInTree(const ItemTree& tree, const TKey& key, size_t& depth)
+    {
+        const Probe probe = probeOf(tree, key);
         const StructItem* item = tree.getTryMiddle();
+        depth = 0;
         while (item)
         {
-
-            const TData& itemData = static_cast<const TStructItem*>(item)->data();
-            const TKey& itemKey = TKeyGet::key(itemData);
-            TKeySort compare;
-            bool less = compare(key, itemKey);
+            ++depth;
+            bool less = keyBefore(tree, key, probe, item);
             if (!less)
             {
-                bool more = compare(itemKey, key);
+                bool more = itemBefore(tree, item, key, probe);
                 if (!more)
                 {
                     // if not less and not more, they must be equal
@@ -367,8 +885,352 @@ public:
         // or via the break when item was found
         if (!item)
             item = tree.getDefault();
+        else if (tree.hasRepeats())
+            item = firstOfKey(tree, key, probe, item, depth);
         return item;
     }
+
+    // finds a key of another type that TKeySort can compare with the keys in
+    // O(log n) time, returns the default item if not found.  the prefixes
+    // are only for TKey, so they are not used
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    static const StructItem* findInTree(const ItemTree& tree, const TOther& key)
+    {
+        size_t depth = 0;
+        return findInTree(tree, key, depth);
+    }
+
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    static const StructItem* findInTree(const ItemTree& tree, const TOther& key, size_t& depth)
+    {
+        TKeySort compare;
+        const StructItem* item = tree.getTryMiddle();
+        depth = 0;
+        while (item)
+        {
+            ++depth;
+            const TKey& itemKey = keyOf(item);
+            if (compare(key, itemKey))
+                item = tree.getTrySmaller(item);
+            else if (compare(itemKey, key))
+                item = tree.getTryLarger(item);
+            else
+                break;
+        }
+        if (!item)
+            return tree.getDefault();
+        return tree.hasRepeats() ? firstOfKey(tree, key, item, depth) : item;
+    }
+
+    // finds count keys, which must be no more than s_batchSize, putting the
+    // item for keys[i] in items[i] with the same result as findInTree.  the
+    // searches take their steps together, and the next item of each one is
+    // prefetched before the others take their step, so that their cache
+    // misses overlap instead of happening one after another
+    static void findManyInTree(const ItemTree& tree, const TKey* keys, size_t count, const StructItem** items)
+    {
+        assert(count <= s_batchSize);
+        // the searches that are still going
+        size_t pending[s_batchSize];
+        size_t pendingCount = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            items[i] = tree.getTryMiddle();
+            if (items[i])
+                pending[pendingCount++] = i;
+        }
+        Probe probes[s_batchSize];
+        for (size_t i = 0; i < count; ++i)
+        {
+            probes[i] = probeOf(tree, keys[i]);
+        }
+        while (pendingCount)
+        {
+            size_t kept = 0;
+            for (size_t p = 0; p < pendingCount; ++p)
+            {
+                const size_t i = pending[p];
+                const StructItem* next;
+                if (keyBefore(tree, keys[i], probes[i], items[i]))
+                    next = tree.getTrySmaller(items[i]);
+                else if (itemBefore(tree, items[i], keys[i], probes[i]))
+                    next = tree.getTryLarger(items[i]);
+                else
+                    continue; // found, so this search is done
+                items[i] = next;
+                if (next)
+                {
+                    STATIC_MAP_PREFETCH(next);
+                    pending[kept++] = i;
+                }
+            }
+            pendingCount = kept;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!items[i])
+            {
+                items[i] = tree.getDefault();
+            }
+            else if (tree.hasRepeats())
+            {
+                size_t depth = 0;
+                items[i] = firstOfKey(tree, keys[i], probes[i], items[i], depth);
+            }
+        }
+    }
+
+    // finds any number of keys using the findMany of the index, a batch at
+    // a time, putting the data for keys[i] (or nullptr) in data[i].  the
+    // cache misses of the searches in a batch overlap, which is faster than
+    // finding each key on its own when the map does not fit in the cache
+    template<typename TIndex>
+    static void findKeys(const TIndex& index, const ItemTree& tree, const TKey* keys, size_t count, const TData** data)
+    {
+        const StructItem* items[s_batchSize];
+        for (size_t first = 0; first < count; first += s_batchSize)
+        {
+            size_t batch = count - first;
+            if (batch > s_batchSize)
+                batch = s_batchSize;
+            index.findMany(tree, keys + first, batch, items);
+            for (size_t i = 0; i < batch; ++i)
+            {
+                const TStructItem* item = static_cast<const TStructItem*>(items[i]);
+                data[first + i] = item ? &(item->data()) : nullptr;
+            }
+        }
+    }
+
+    // finds the first item whose key is not less than the key in O(log n)
+    // time, returns nullptr if there is none
+    static const StructItem* lowerBoundInTree(const ItemTree& tree, const TKey& key)
+    {
+        const Probe probe = probeOf(tree, key);
+        const StructItem* bound = nullptr;
+        const StructItem* item = tree.getTryMiddle();
+        while (item)
+        {
+            if (itemBefore(tree, item, key, probe))
+            {
+                // too small, so the bound is larger
+                item = tree.getTryLarger(item);
+            }
+            else
+            {
+                // this could be the bound, but there may be one smaller
+                bound = item;
+                item = tree.getTrySmaller(item);
+            }
+        }
+        return bound;
+    }
+
+    // finds the first item whose key is greater than the key in O(log n)
+    // time, returns nullptr if there is none
+    static const StructItem* upperBoundInTree(const ItemTree& tree, const TKey& key)
+    {
+        const Probe probe = probeOf(tree, key);
+        const StructItem* bound = nullptr;
+        const StructItem* item = tree.getTryMiddle();
+        while (item)
+        {
+            if (keyBefore(tree, key, probe, item))
+            {
+                // this could be the bound, but there may be one smaller
+                bound = item;
+                item = tree.getTrySmaller(item);
+            }
+            else
+            {
+                // not greater, so the bound is larger
+                item = tree.getTryLarger(item);
+            }
+        }
+        return bound;
+    }
+
+    // returns true if the item has the key
+    template<typename TSearch>
+    static bool isKeyOf(const StructItem* item, const TSearch& key)
+    {
+        TKeySort compare;
+        return !compare(key, keyOf(item)) && !compare(keyOf(item), key);
+    }
+
+    // gets the key of an item
+    static const TKey& keyOf(const StructItem* item)
+    {
+        return TKeyGet::key(static_cast<const TStructItem*>(item)->data());
+    }
+
+private:
+    // gets the data of an item
+    static const TData& dataOf(const StructItem* item) { return static_cast<const TStructItem*>(item)->data(); }
+
+    // the length of the start that all of the keys in the array share
+    static size_t sharedLength(ItemArray& array)
+    {
+        StructItem* first = array.getFirst();
+        if (!first || !array.getNext(first))
+            return 0;
+        size_t shared = std::numeric_limits<size_t>::max();
+        for (StructItem* item = array.getNext(first); item && shared != 0; item = array.getNext(item))
+        {
+            shared = TKeyCache::sharedLength(keyOf(first), keyOf(item), shared);
+        }
+        return shared;
+    }
+
+    // what a search compares with the prefixes in the items.  a key that
+    // does not start the way that all of the keys do has no prefix to
+    // compare, and is always compared in full
+    struct Probe
+    {
+        uint64_t m_prefix;
+        bool m_isCached;
+    };
+
+    static Probe probeOf(const ItemTree& tree, const TKey& key)
+    {
+        Probe probe = {0, s_useKeyCache};
+        if (s_useKeyCache)
+        {
+            const size_t skip = tree.getKeySkip();
+            if (skip != 0 && TKeyCache::sharedLength(key, keyOf(tree.getFirst()), skip) != skip)
+                probe.m_isCached = false;
+            else
+                probe.m_prefix = TKeyCache::prefixOf(key, skip);
+        }
+        return probe;
+    }
+
+    // returns true if the key goes before the key of the item in the tree,
+    // only going to the item for its key when the prefixes cannot tell
+    static bool keyBefore(const ItemTree& tree, const TKey& key, const Probe& probe, const StructItem* item)
+    {
+        if (probe.m_isCached)
+        {
+            const uint64_t itemPrefix = tree.getKeyCache(item);
+            if (probe.m_prefix != itemPrefix)
+                return probe.m_prefix < itemPrefix;
+            if (TKeyCache::isWhole(itemPrefix))
+                return false;
+        }
+        TKeySort compare;
+        return compare(key, keyOf(item));
+    }
+
+    // returns true if the key of the item in the tree goes before the key
+    static bool itemBefore(const ItemTree& tree, const StructItem* item, const TKey& key, const Probe& probe)
+    {
+        if (probe.m_isCached)
+        {
+            const uint64_t itemPrefix = tree.getKeyCache(item);
+            if (probe.m_prefix != itemPrefix)
+                return itemPrefix < probe.m_prefix;
+            if (TKeyCache::isWhole(itemPrefix))
+                return false;
+        }
+        TKeySort compare;
+        return compare(keyOf(item), key);
+    }
+    // when the tree has repeats, the item that a search stopped at may not be
+    // the first with its key.  the ones before it are all in its smaller
+    // subtree, since the search would have stopped at any above it, so the
+    // first is found by going on down from there like lowerBoundInTree
+    static const StructItem* firstOfKey(const ItemTree& tree, const TKey& key, const Probe& probe,
+                                        const StructItem* found, size_t& depth)
+    {
+        const StructItem* item = tree.getTrySmaller(found);
+        while (item)
+        {
+            ++depth;
+            if (itemBefore(tree, item, key, probe))
+            {
+                item = tree.getTryLarger(item);
+            }
+            else
+            {
+                found = item;
+                item = tree.getTrySmaller(item);
+            }
+        }
+        return found;
+    }
+
+    template<typename TOther>
+    static const StructItem* firstOfKey(const ItemTree& tree, const TOther& key, const StructItem* found,
+                                        size_t& depth)
+    {
+        TKeySort compare;
+        const StructItem* item = tree.getTrySmaller(found);
+        while (item)
+        {
+            ++depth;
+            if (compare(keyOf(item), key))
+            {
+                item = tree.getTryLarger(item);
+            }
+            else
+            {
+                found = item;
+                item = tree.getTrySmaller(item);
+            }
+        }
+        return found;
+    }
+};
+
+//
+// TreeIndex: the default lookup index of a map, which searches the tree
+// itself.  A map can be given another index to use for its lookups.  Every
+// index takes the same template parameters as TreeFuncs and has:
+//   Storage -- what the caller passes to the map to hold the index.  the
+//              index is only built if the storage is big enough, otherwise
+//              it will fall back on searching the tree
+//   build(tree) -- fills the index once the tree has been constructed
+//   find(tree, key) -- finds the item with the same result as findInTree,
+//              and when TKeySort is transparent, is also a template that
+//              finds a key of another type
+//   findMany(tree, keys, count, items) -- does find for up to s_batchSize
+//              keys of TreeFuncs at once, overlapping their memory reads
+//
+template<typename TData, typename TKey, typename TKeyGet, typename TKeySort>
+class TreeIndex
+{
+private:
+    typedef TreeFuncs<TData, TKey, TKeyGet, TKeySort> TreeUtil;
+
+public:
+    // nothing needs to be stored
+    struct Storage
+    {
+    };
+
+public:
+    TreeIndex() = default;
+    explicit TreeIndex(const Storage&) {}
+    ~TreeIndex() = default;
+
+private:
+    TreeIndex(const TreeIndex&) = delete;
+    TreeIndex& operator=(const TreeIndex&) = delete;
+
+public:
+    void build(const ItemTree&) {}
+    // the tree is always searched
+    bool isBuilt() const { return false; }
+    const StructItem* find(const ItemTree& tree, const TKey& key) const { return TreeUtil::findInTree(tree, key); }
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    const StructItem* find(const ItemTree& tree, const TOther& key) const
+    {
+        return TreeUtil::findInTree(tree, key);
+    }
+    void findMany(const ItemTree& tree, const TKey* keys, size_t count, const StructItem** items) const
+    {
+        TreeUtil::findManyInTree(tree, keys, count, items);
+    }
 };
 
 } // namespace static_map
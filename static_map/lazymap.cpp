@@ -0,0 +1,10 @@
+//
+//  lazymap.cpp
+//  StaticMap
+//
+
+#include "lazymap.hpp"
+
+namespace static_map
+{
+}
@@ -0,0 +1,154 @@
+//
+//  lazymap.hpp
+//  StaticMap
+//
+
+#ifndef lazymap_hpp
+#define lazymap_hpp
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+namespace static_map
+{
+
+//
+// LazyMap: holds a UniMap, RefMap or BiMap that is not constructed until it
+// is first used.  The other maps sort and link their items in their
+// constructors during static initialization, which costs time at startup
+// even for maps a process never uses, and gives a wrong map if an Item in
+// another file has not been added to the Builder yet.  A LazyMap only keeps
+// the Builder, and constructs the map from it the first time get or -> is
+// called:
+//
+// typedef UniMap<int, const char*> M;
+// static M::Builder s_builder;
+// static M::Item s_i1(s_builder, 1, "ONE");
+// static LazyMap<M> s_map(s_builder);
+//
+// const M::Item* i = s_map->findKey(1);
+//
+// The LazyMap and the Builders are constructed at compile time, so they are
+// ready before any Item is constructed, wherever it is.  If several threads
+// use the map first at the same time, one of them constructs it and the
+// others wait for it.  Once it is constructed, each use costs one acquire
+// load.  A map that needs index storage is constructed by a function given
+// with the Builder:
+//
+// static void makeMap(void* place, M::Builder& builder) { new (place) M(builder, s_slots); }
+// static LazyMap<M> s_map(s_builder, makeMap);
+//
+// If the function throws, the exception goes to the caller and the map is
+// left unconstructed, so the next use tries again.  No Item may be added to
+// the Builder after the map has been used.
+//
+template<typename TMap>
+class LazyMap
+{
+public:
+    typedef LazyMap<TMap> ThisType;
+    typedef typename TMap::TBuilder TBuilder;
+    // constructs the map at place from the builder
+    typedef void (*TMake)(void* place, TBuilder& builder);
+
+public:
+    constexpr explicit LazyMap(TBuilder& builder, TMake make = &makeMap) :
+        m_builder(&builder),
+        m_make(make),
+        m_state(s_empty),
+        m_storage{}
+    {
+    }
+    ~LazyMap()
+    {
+        if (isBuilt())
+            map().~TMap();
+    }
+
+private:
+    LazyMap(const LazyMap&) = delete;
+    LazyMap& operator=(const LazyMap&) = delete;
+
+public:
+    // returns true if the map has been constructed
+    bool isBuilt() const { return m_state.load(std::memory_order_acquire) == s_built; }
+    // constructs the map if it has not been yet, to do it at a time that
+    // is known instead of on first use
+    void build() const
+    {
+        if (!isBuilt())
+            buildOnce();
+    }
+    // gets the map, constructing it if it has not been yet
+    const TMap& get() const
+    {
+        build();
+        return map();
+    }
+    const TMap* operator->() const { return &get(); }
+    const TMap& operator*() const { return get(); }
+
+private:
+    static void makeMap(void* place, TBuilder& builder) { new (place) TMap(builder); }
+
+    const TMap& map() const { return *reinterpret_cast<const TMap*>(m_storage); }
+
+    // the slow path, taken until the map is constructed
+    void buildOnce() const
+    {
+        for (;;)
+        {
+            int state = s_empty;
+            if (m_state.compare_exchange_strong(state, s_building, std::memory_order_acquire))
+            {
+                BuildGuard guard(m_state);
+                m_make(m_storage, *m_builder);
+                guard.m_final = s_built;
+                return;
+            }
+            if (state == s_built)
+                return;
+            // another thread is constructing it, and if it fails, this one
+            // tries
+            while (m_state.load(std::memory_order_acquire) == s_building)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // sets the state when it goes out of scope, which is back to empty
+    // unless the map was constructed
+    class BuildGuard
+    {
+    public:
+        explicit BuildGuard(std::atomic<int>& state) : m_final(s_empty), m_target(state) {}
+        ~BuildGuard() { m_target.store(m_final, std::memory_order_release); }
+
+    private:
+        BuildGuard(const BuildGuard&) = delete;
+        BuildGuard& operator=(const BuildGuard&) = delete;
+
+    public:
+        int m_final;
+
+    private:
+        std::atomic<int>& m_target;
+    };
+
+private:
+    static const int s_empty = 0;
+    static const int s_building = 1;
+    static const int s_built = 2;
+
+private:
+    TBuilder* m_builder;
+    TMake m_make;
+    mutable std::atomic<int> m_state;
+    alignas(TMap) mutable unsigned char m_storage[sizeof(TMap)];
+};
+
+} // namespace static_map
+
+#endif /* lazymap_hpp */
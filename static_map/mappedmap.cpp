@@ -0,0 +1,10 @@
+//
+//  mappedmap.cpp
+//  StaticMap
+//
+
+#include "mappedmap.hpp"
+
+namespace static_map
+{
+}
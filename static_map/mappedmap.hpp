@@ -0,0 +1,378 @@
+//
+//  mappedmap.hpp
+//  StaticMap
+//
+
+#ifndef mappedmap_hpp
+#define mappedmap_hpp
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+
+#include "snapshot.hpp"
+
+namespace static_map
+{
+
+//
+// SnapshotSequence: goes over the records of a section in order, like the
+// Sequence of the other maps.  The records are in an array, so the
+// iterators are pointers.
+//
+template<typename TItem>
+class SnapshotSequence
+{
+public:
+    typedef const TItem* const_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+public:
+    SnapshotSequence(const TItem* items, size_t count) : m_items(items), m_count(count) {}
+
+public:
+    const_iterator begin() const { return m_items; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator end() const { return m_items + m_count; }
+    const_iterator cend() const { return end(); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crend() const { return rend(); }
+
+private:
+    const TItem* m_items;
+    size_t m_count;
+};
+
+//
+// SnapshotFuncs: the search of a section of records sorted by the key that
+// TKeyGet gets from them
+//
+template<typename TItem, typename TKey, typename TKeyGet, typename TKeySort>
+class SnapshotFuncs
+{
+public:
+    // finds the key in O(log n) time, returns nullptr if not found
+    static const TItem* findInSection(const TItem* items, size_t count, const TKey& key)
+    {
+        TKeySort compare;
+        const TItem* end = items + count;
+        const TItem* first = items;
+        while (count > 0)
+        {
+            const size_t step = count / 2;
+            const TItem* middle = first + step;
+            if (compare(TKeyGet::key(*middle), key))
+            {
+                first = middle + 1;
+                count -= step + 1;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+        const bool found = (first != end) && !compare(key, TKeyGet::key(*first));
+        return found ? first : nullptr;
+    }
+
+    // gets the default item of a map that has getDefault, or nullptr
+    template<typename TMap>
+    static auto defaultOf(const TMap& map, int) -> decltype(map.getDefault())
+    {
+        return map.getDefault();
+    }
+    template<typename TMap>
+    static const void* defaultOf(const TMap&, long)
+    {
+        return nullptr;
+    }
+};
+
+//
+// MappedMap: a read only map that is used straight from a snapshot file
+// mapped into memory, for maps that are too big to be compiled in as static
+// items.  The snapshot is made from a built UniMap (or any map with a
+// sequence of items that have key and val) by write, usually by a tool that
+// runs ahead of time:
+//
+// typedef MappedMap<int, const char*> M;
+// M::write(s_map, "names.snap");
+//
+// and then each process that uses it maps it:
+//
+// static M s_names("names.snap");
+// const M::Item* i = s_names.findKey(7);
+//
+// Opening it only maps the file and checks its header; nothing is parsed,
+// copied or allocated, and findKey and sequence read the mapping.  TKey and
+// TVal must be numbers, enums or C strings (see SnapshotValue), and TKeySort
+// must order the keys the same way as the map that was written.  If the map
+// that was written has a default item, findKey gives it for a key that is
+// not found, as the map does.  If the file cannot be used, isOpen is false
+// and the map is empty.
+//
+template<typename TKey, typename TVal, typename TKeySort = std::less<TKey>>
+class MappedMap
+{
+public:
+    class Item;
+    typedef MappedMap<TKey, TVal, TKeySort> ThisType;
+    typedef Item TData;
+    typedef SnapshotSequence<Item> TSequence;
+
+private:
+    class GetKey;
+    typedef SnapshotFuncs<Item, TKey, GetKey, TKeySort> SectionUtil;
+
+public:
+    //
+    // Item is a record in the snapshot.  The key and value are given back
+    // by value since strings are found from where the record is.
+    //
+    class Item
+    {
+        friend class MappedMap;
+
+    public:
+        TKey key() const { return m_key.get(); }
+        TVal val() const { return m_val.get(); }
+
+    private:
+        Item() = delete;
+        Item(const Item&) = delete;
+        Item& operator=(const Item&) = delete;
+
+    private:
+        SnapshotValue<TKey> m_key;
+        SnapshotValue<TVal> m_val;
+    };
+
+private:
+    class GetKey
+    {
+    public:
+        static TKey key(const Item& item) { return item.key(); }
+    };
+
+public:
+    explicit MappedMap(const char* path) : m_file(), m_items(nullptr), m_count(0), m_default(nullptr)
+    {
+        if (m_file.open(path, sizeof(Item), 1))
+        {
+            m_items = static_cast<const Item*>(m_file.getRecords(0));
+            m_count = m_file.getCount(0);
+            m_default = static_cast<const Item*>(m_file.getDefault(0));
+        }
+    }
+    ~MappedMap() = default;
+
+private:
+    MappedMap(const MappedMap&) = delete;
+    MappedMap& operator=(const MappedMap&) = delete;
+
+public:
+    // returns true if the snapshot was mapped
+    bool isOpen() const { return m_file.isOpen(); }
+    // finds the key in O(log n) time, returns the default item if not
+    // found, or nullptr if there is none
+    const TData* findKey(const TKey& key) const
+    {
+        const TData* item = SectionUtil::findInSection(m_items, m_count, key);
+        return item ? item : m_default;
+    }
+    // the default item, if any
+    const TData* getDefault() const { return m_default; }
+    TSequence sequence() const { return TSequence(m_items, m_count); }
+    size_t size() const { return m_count; }
+
+public:
+    // writes the items of the map to a snapshot file in the order of its
+    // sequence, and which of them is the default if the map has getDefault,
+    // returns false if the file cannot be written
+    template<typename TMap>
+    static bool write(const TMap& map, const char* path)
+    {
+        typename TMap::TSequence seq = map.sequence();
+        const size_t count = static_cast<size_t>(std::distance(seq.begin(), seq.end()));
+        const auto def = SectionUtil::defaultOf(map, 0);
+        SnapshotWriter writer(sizeof(Item));
+        size_t pos = writer.addSection(count);
+        size_t index = 0;
+        for (typename TMap::TSequence::const_iterator it = seq.begin(); it != seq.end(); ++it, ++index)
+        {
+            writer.put<TKey>(pos + offsetof(Item, m_key), it->key());
+            writer.put<TVal>(pos + offsetof(Item, m_val), it->val());
+            if (&*it == def)
+                writer.setDefault(0, index);
+            pos += sizeof(Item);
+        }
+        return writer.writeTo(path);
+    }
+
+private:
+    SnapshotFile m_file;
+    const Item* m_items;
+    size_t m_count;
+    const Item* m_default;
+};
+
+//
+// MappedBiMap: a read only BiMap that is used straight from a snapshot file,
+// like MappedMap.  The snapshot holds the items of each side of the BiMap
+// sorted by that side's key, so items that have only one key are only found
+// by that key, as in the BiMap.  The default item, if any, is found for a
+// key of either side that is not found.
+//
+// typedef MappedBiMap<int, const char*, std::less<int>, StrLess> M;
+// M::write(s_biMap, "symbols.snap");
+// static M s_symbols("symbols.snap");
+//
+template<typename TKey1, typename TKey2, typename TKey1Sort = std::less<TKey1>, typename TKey2Sort = std::less<TKey2>>
+class MappedBiMap
+{
+public:
+    class Item;
+    typedef MappedBiMap<TKey1, TKey2, TKey1Sort, TKey2Sort> ThisType;
+    typedef Item TData;
+    typedef SnapshotSequence<Item> TSequence1;
+    typedef SnapshotSequence<Item> TSequence2;
+
+private:
+    class GetKey1;
+    class GetKey2;
+    typedef SnapshotFuncs<Item, TKey1, GetKey1, TKey1Sort> Section1Util;
+    typedef SnapshotFuncs<Item, TKey2, GetKey2, TKey2Sort> Section2Util;
+
+public:
+    //
+    // Item is a record in the snapshot, holding both keys
+    //
+    class Item
+    {
+        friend class MappedBiMap;
+
+    public:
+        TKey1 key1() const { return m_key1.get(); }
+        TKey2 key2() const { return m_key2.get(); }
+
+    private:
+        Item() = delete;
+        Item(const Item&) = delete;
+        Item& operator=(const Item&) = delete;
+
+    private:
+        SnapshotValue<TKey1> m_key1;
+        SnapshotValue<TKey2> m_key2;
+    };
+
+private:
+    class GetKey1
+    {
+    public:
+        static TKey1 key(const Item& item) { return item.key1(); }
+    };
+
+    class GetKey2
+    {
+    public:
+        static TKey2 key(const Item& item) { return item.key2(); }
+    };
+
+public:
+    explicit MappedBiMap(const char* path) :
+        m_file(),
+        m_items1(nullptr),
+        m_count1(0),
+        m_default1(nullptr),
+        m_items2(nullptr),
+        m_count2(0),
+        m_default2(nullptr)
+    {
+        if (m_file.open(path, sizeof(Item), 2))
+        {
+            m_items1 = static_cast<const Item*>(m_file.getRecords(0));
+            m_count1 = m_file.getCount(0);
+            m_default1 = static_cast<const Item*>(m_file.getDefault(0));
+            m_items2 = static_cast<const Item*>(m_file.getRecords(1));
+            m_count2 = m_file.getCount(1);
+            m_default2 = static_cast<const Item*>(m_file.getDefault(1));
+        }
+    }
+    ~MappedBiMap() = default;
+
+private:
+    MappedBiMap(const MappedBiMap&) = delete;
+    MappedBiMap& operator=(const MappedBiMap&) = delete;
+
+public:
+    // returns true if the snapshot was mapped
+    bool isOpen() const { return m_file.isOpen(); }
+    // find either key in O(log n) time, return the default item if not
+    // found, or nullptr if there is none
+    const TData* findKey1(const TKey1& key) const
+    {
+        const TData* item = Section1Util::findInSection(m_items1, m_count1, key);
+        return item ? item : m_default1;
+    }
+    const TData* findKey2(const TKey2& key) const
+    {
+        const TData* item = Section2Util::findInSection(m_items2, m_count2, key);
+        return item ? item : m_default2;
+    }
+    TSequence1 sequence1() const { return TSequence1(m_items1, m_count1); }
+    TSequence2 sequence2() const { return TSequence2(m_items2, m_count2); }
+
+public:
+    // writes the items of both sides of the BiMap to a snapshot file, and
+    // which of them is the default if the BiMap has getDefault, returns
+    // false if the file cannot be written
+    template<typename TBiMap>
+    static bool write(const TBiMap& map, const char* path)
+    {
+        typename TBiMap::TSequence1 seq1 = map.sequence1();
+        typename TBiMap::TSequence2 seq2 = map.sequence2();
+        const auto def = Section1Util::defaultOf(map, 0);
+        SnapshotWriter writer(sizeof(Item));
+        size_t pos1 = writer.addSection(static_cast<size_t>(std::distance(seq1.begin(), seq1.end())));
+        size_t pos2 = writer.addSection(static_cast<size_t>(std::distance(seq2.begin(), seq2.end())));
+        size_t index = 0;
+        for (typename TBiMap::TSequence1::const_iterator it = seq1.begin(); it != seq1.end(); ++it, ++index)
+        {
+            putItem(writer, pos1, it->key1(), it->key2());
+            if (&*it == def)
+                writer.setDefault(0, index);
+            pos1 += sizeof(Item);
+        }
+        index = 0;
+        for (typename TBiMap::TSequence2::const_iterator it = seq2.begin(); it != seq2.end(); ++it, ++index)
+        {
+            putItem(writer, pos2, it->key1(), it->key2());
+            if (&*it == def)
+                writer.setDefault(1, index);
+            pos2 += sizeof(Item);
+        }
+        return writer.writeTo(path);
+    }
+
+private:
+    static void putItem(SnapshotWriter& writer, size_t pos, const TKey1& key1, const TKey2& key2)
+    {
+        writer.put<TKey1>(pos + offsetof(Item, m_key1), key1);
+        writer.put<TKey2>(pos + offsetof(Item, m_key2), key2);
+    }
+
+private:
+    SnapshotFile m_file;
+    const Item* m_items1;
+    size_t m_count1;
+    const Item* m_default1;
+    const Item* m_items2;
+    size_t m_count2;
+    const Item* m_default2;
+};
+
+} // namespace static_map
+
+#endif /* mappedmap_hpp */
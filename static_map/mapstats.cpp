@@ -0,0 +1,124 @@
+//
+//  mapstats.cpp
+//  StaticMap
+//
+
+#include "mapstats.hpp"
+
+#include <mutex>
+#include <ostream>
+
+namespace static_map
+{
+
+// the list of every LookupStats.  these are constant initialized, so maps
+// constructed during static initialization can use them
+static std::mutex s_listMutex;
+static LookupStats* s_first = nullptr;
+static LookupStats* s_last = nullptr;
+
+LookupStats::LookupStats(const char* name, const char* part) :
+    m_name(name ? name : ""),
+    m_part(part ? part : ""),
+    m_shards(),
+    m_next(nullptr),
+    m_prev(nullptr)
+{
+    for (size_t s = 0; s < s_shardCount; ++s)
+    {
+        Shard& shard = m_shards[s];
+        shard.m_lookups.store(0, std::memory_order_relaxed);
+        shard.m_misses.store(0, std::memory_order_relaxed);
+        shard.m_defaults.store(0, std::memory_order_relaxed);
+        for (size_t d = 0; d < LookupCounts::s_depthCount; ++d)
+        {
+            shard.m_depths[d].store(0, std::memory_order_relaxed);
+        }
+    }
+    std::lock_guard<std::mutex> lock(s_listMutex);
+    m_prev = s_last;
+    if (s_last)
+        s_last->m_next = this;
+    else
+        s_first = this;
+    s_last = this;
+}
+
+LookupStats::~LookupStats()
+{
+    std::lock_guard<std::mutex> lock(s_listMutex);
+    if (m_prev)
+        m_prev->m_next = m_next;
+    else
+        s_first = m_next;
+    if (m_next)
+        m_next->m_prev = m_prev;
+    else
+        s_last = m_prev;
+}
+
+LookupCounts LookupStats::getCounts() const
+{
+    LookupCounts counts = {};
+    for (size_t s = 0; s < s_shardCount; ++s)
+    {
+        const Shard& shard = m_shards[s];
+        counts.m_lookups += shard.m_lookups.load(std::memory_order_relaxed);
+        counts.m_misses += shard.m_misses.load(std::memory_order_relaxed);
+        counts.m_defaults += shard.m_defaults.load(std::memory_order_relaxed);
+        for (size_t d = 0; d < LookupCounts::s_depthCount; ++d)
+        {
+            counts.m_depths[d] += shard.m_depths[d].load(std::memory_order_relaxed);
+        }
+    }
+    return counts;
+}
+
+// like: names key1 lookups=10 misses=2 defaults=1 depths=0:4,2:3,3:3
+// where only the depths that some lookup had are written
+void LookupStats::dump(std::ostream& out) const
+{
+    const LookupCounts counts = getCounts();
+    out << m_name;
+    if (*m_part)
+        out << " " << m_part;
+    out << " lookups=" << counts.m_lookups << " misses=" << counts.m_misses << " defaults=" << counts.m_defaults
+        << " depths=";
+    const char* separator = "";
+    for (size_t d = 0; d < LookupCounts::s_depthCount; ++d)
+    {
+        if (counts.m_depths[d])
+        {
+            out << separator << d << ":" << counts.m_depths[d];
+            separator = ",";
+        }
+    }
+    out << std::endl;
+}
+
+void LookupStats::forEach(void (*visit)(const LookupStats& stats, void* context), void* context)
+{
+    std::lock_guard<std::mutex> lock(s_listMutex);
+    for (const LookupStats* stats = s_first; stats; stats = stats->m_next)
+    {
+        visit(*stats, context);
+    }
+}
+
+static void dumpOne(const LookupStats& stats, void* context)
+{
+    stats.dump(*static_cast<std::ostream*>(context));
+}
+
+void LookupStats::dumpAll(std::ostream& out)
+{
+    forEach(&dumpOne, &out);
+}
+
+size_t LookupStats::nextShard()
+{
+    static std::atomic<size_t> s_nextShard(0);
+    return s_nextShard.fetch_add(1, std::memory_order_relaxed) % s_shardCount;
+}
+
+} // namespace static_map
@@ -0,0 +1,208 @@
+//
+//  mapstats.hpp
+//  StaticMap
+//
+
+#ifndef mapstats_hpp
+#define mapstats_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "itemtree.hpp"
+
+namespace static_map
+{
+
+//
+// The maps take a stats policy, TStats, that is told about every findKey
+// (and findKeys) so that the maps that are used the most, and the ones that
+// miss, can be found in a running program:
+//
+// typedef UniMap<int, const char*, std::less<int>, TreeIndex, LookupStats> M;
+// static M s_map(s_builder, M::TIndexStorage(), "names");
+// ...
+// LookupStats::dumpAll(std::cerr);
+//
+// NoStats, the default, keeps nothing, and every call to it compiles away.
+//
+
+//
+// NoStats: the policy of maps that are not measured
+//
+class NoStats
+{
+public:
+    static const bool isEnabled = false;
+
+public:
+    constexpr explicit NoStats(const char* = nullptr, const char* = nullptr) {}
+
+public:
+    void recordFind(bool, bool, size_t) const {}
+};
+
+//
+// LookupCounts: what a LookupStats has counted, added up over its shards
+//
+struct LookupCounts
+{
+    // the number of depths kept, the last one holding all that are deeper
+    static const size_t s_depthCount = 29;
+
+    uint64_t m_lookups;
+    // lookups that found nothing and gave back nullptr
+    uint64_t m_misses;
+    // lookups that found nothing and gave back the default item
+    uint64_t m_defaults;
+    // how many lookups looked at each number of items in the tree.  depth 0
+    // is a lookup that did not search the tree one key at a time, because
+    // the index answered it or it was part of a findKeys
+    uint64_t m_depths[s_depthCount];
+};
+
+//
+// LookupStats: counts the lookups of a map, with the misses, the lookups
+// that fell through to the default item, and how deep the tree searches
+// went.  The counters are split into shards, and each thread adds to the
+// shard it is given the first time it looks something up, so threads rarely
+// add to the same cache line.  The adds are relaxed, so the counts of a map
+// that is in use are only about right.
+//
+// Every LookupStats puts itself on a list when it is constructed, which
+// forEach and dumpAll go through.
+//
+class LookupStats
+{
+public:
+    static const bool isEnabled = true;
+
+public:
+    explicit LookupStats(const char* name = nullptr, const char* part = nullptr);
+    ~LookupStats();
+
+private:
+    LookupStats(const LookupStats&) = delete;
+    LookupStats& operator=(const LookupStats&) = delete;
+
+public:
+    // counts a lookup.  found and usedDefault cannot both be true, and
+    // depth is the number of items of the tree looked at, 0 if unknown
+    void recordFind(bool found, bool usedDefault, size_t depth) const
+    {
+        Shard& shard = m_shards[shardIndex()];
+        shard.m_lookups.fetch_add(1, std::memory_order_relaxed);
+        if (!found)
+            (usedDefault ? shard.m_defaults : shard.m_misses).fetch_add(1, std::memory_order_relaxed);
+        const size_t last = LookupCounts::s_depthCount - 1;
+        shard.m_depths[(depth < last) ? depth : last].fetch_add(1, std::memory_order_relaxed);
+    }
+
+public:
+    // the name of the map given when it was constructed, and which part of
+    // it, like key1 of a BiMap
+    const char* getName() const { return m_name; }
+    const char* getPart() const { return m_part; }
+    // adds up the shards
+    LookupCounts getCounts() const;
+    // writes the counts on one line
+    void dump(std::ostream& out) const;
+
+public:
+    // calls visit for each LookupStats that exists, in the order that they
+    // were constructed
+    static void forEach(void (*visit)(const LookupStats& stats, void* context), void* context);
+    // writes the counts of every LookupStats
+    static void dumpAll(std::ostream& out);
+
+private:
+    static const size_t s_cacheLine = 64;
+
+    // the counters of some of the threads, a whole number of cache lines
+    // that starts on a line, so that no two shards share a line.  this
+    // makes a LookupStats aligned to a line, which a static or local map
+    // is, but one made with new may not be before C++17
+    struct alignas(s_cacheLine) Shard
+    {
+        std::atomic<uint64_t> m_lookups;
+        std::atomic<uint64_t> m_misses;
+        std::atomic<uint64_t> m_defaults;
+        std::atomic<uint64_t> m_depths[LookupCounts::s_depthCount];
+    };
+    static_assert(sizeof(Shard) % s_cacheLine == 0, "a shard is a whole number of cache lines");
+
+    static const size_t s_shardCount = 8;
+
+    // the shard of the thread that is running
+    static size_t shardIndex()
+    {
+        thread_local size_t t_shard = nextShard();
+        return t_shard;
+    }
+    static size_t nextShard();
+
+private:
+    const char* m_name;
+    const char* m_part;
+    mutable Shard m_shards[s_shardCount];
+    // the list of all of them
+    LookupStats* m_next;
+    LookupStats* m_prev;
+};
+
+//
+// StatsFuncs: how a map looks up keys and tells its stats about them
+//
+template<typename TreeUtil, typename TIndex, typename TStats>
+class StatsFuncs
+{
+public:
+    // finds the key with the index, or if the index has nothing built, by
+    // searching the tree here so that the depth can be counted
+    template<typename TSearch>
+    static const StructItem* find(const TIndex& index, const ItemTree& tree, const TStats& stats, const TSearch& key)
+    {
+        if (!TStats::isEnabled)
+            return index.find(tree, key);
+        size_t depth = 0;
+        const StructItem* item = index.isBuilt() ? index.find(tree, key) : TreeUtil::findInTree(tree, key, depth);
+        record(tree, stats, item, key, depth);
+        return item;
+    }
+
+    // counts the lookups of a findKeys once it is done
+    template<typename TKey, typename TData>
+    static void recordMany(const ItemTree& tree, const TStats& stats, const TKey* keys, size_t count,
+                           const TData* const* items)
+    {
+        if (!TStats::isEnabled)
+            return;
+        const StructItem* def = tree.getDefault();
+        const TData* defaultData = def ? &(static_cast<const StructItemT<TData>*>(def)->data()) : nullptr;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!items[i])
+                stats.recordFind(false, false, 0);
+            else if (items[i] == defaultData && !TreeUtil::isKeyOf(def, keys[i]))
+                stats.recordFind(false, true, 0);
+            else
+                stats.recordFind(true, false, 0);
+        }
+    }
+
+private:
+    template<typename TSearch>
+    static void record(const ItemTree& tree, const TStats& stats, const StructItem* item, const TSearch& key,
+                       size_t depth)
+    {
+        // the default item is only a miss if it does not have the key
+        const bool usedDefault = item && item == tree.getDefault() && !TreeUtil::isKeyOf(item, key);
+        stats.recordFind(item && !usedDefault, usedDefault, depth);
+    }
+};
+
+} // namespace static_map
+
+#endif /* mapstats_hpp */
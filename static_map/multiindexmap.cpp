@@ -0,0 +1,10 @@
+//
+//  multiindexmap.cpp
+//  StaticMap
+//
+
+#include "multiindexmap.hpp"
+
+namespace static_map
+{
+}
@@ -0,0 +1,326 @@
+//
+//  multiindexmap.hpp
+//  StaticMap
+//
+
+#ifndef multiindexmap_hpp
+#define multiindexmap_hpp
+
+#include "builderbase.hpp"
+#include "denseindex.hpp"
+#include "eytzinger.hpp"
+#include "itemtree.hpp"
+#include "perfecthash.hpp"
+#include "ranked.hpp"
+#include "sequence.hpp"
+#include "stree.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <utility>
+
+namespace static_map
+{
+
+//
+// A MultiIndexMap is a BiMap with any number of keys.  Every item has all of
+// the keys and is in the tree of each of them, and each key has its own
+// order and lookup engine:
+//
+// typedef MultiIndexMap<const char*, MultiKey<int, std::less<int>, DenseIndex>,
+//                       MultiKey<const char*, StrLess, PerfectHashIndex>> M;
+// static M::Builder s_builder;
+// static const M::Item s_item(s_builder, "Acme", 1, "ACME");
+// static M s_map(s_builder, M::TIndexStorage<0>(...), M::TIndexStorage<1>(...));
+// ...
+// const M::Item* item = s_map.findKey<1>("ACME");
+//
+
+//
+// MultiKey: one key of a MultiIndexMap, how it is sorted and how it is
+// looked up.  A key given as a plain type is MultiKey<T>.
+//
+template<typename TKey, typename TKeySort = std::less<TKey>,
+         template<typename, typename, typename, typename> class TLookup = TreeIndex>
+struct MultiKey
+{
+    typedef TKey Key;
+    typedef TKeySort KeySort;
+    template<typename TData, typename TKeyOf, typename TKeyGet, typename TKeyOfSort>
+    using Lookup = TLookup<TData, TKeyOf, TKeyGet, TKeyOfSort>;
+};
+
+template<typename T>
+struct MultiKeyOf
+{
+    typedef MultiKey<T> Type;
+};
+
+template<typename TKey, typename TKeySort, template<typename, typename, typename, typename> class TLookup>
+struct MultiKeyOf<MultiKey<TKey, TKeySort, TLookup>>
+{
+    typedef MultiKey<TKey, TKeySort, TLookup> Type;
+};
+
+//
+//
+//
+
+template<typename TVal, typename TKeyIndices, typename... TKeys>
+class MultiIndexMapBase;
+
+template<typename TVal, size_t... Is, typename... TKeys>
+class MultiIndexMapBase<TVal, std::index_sequence<Is...>, TKeys...>
+{
+public:
+    class Builder;
+    class Item;
+    typedef Builder TBuilder;
+    typedef Item TData;
+    typedef DuplicatePolicy<TData> TDuplicates;
+    typedef WeightPolicy<TData> TWeights;
+
+    static const size_t s_keyCount = sizeof...(TKeys);
+
+public:
+    template<size_t I>
+    using TKeySpec = typename std::tuple_element<I, std::tuple<typename MultiKeyOf<TKeys>::Type...>>::type;
+    template<size_t I>
+    using TKey = typename TKeySpec<I>::Key;
+    template<size_t I>
+    using TKeySort = typename TKeySpec<I>::KeySort;
+
+private:
+    template<size_t I>
+    class GetKey;
+    typedef StructItemT<TData> TStructItem;
+    template<size_t I>
+    using TreeUtil = TreeFuncs<TData, TKey<I>, GetKey<I>, TKeySort<I>>;
+
+public:
+    template<size_t I>
+    using TSequence = Sequence<TData, TKey<I>, GetKey<I>, TKeySort<I>>;
+    template<size_t I>
+    using TIterator = typename TSequence<I>::const_iterator;
+    template<size_t I>
+    using TRanked = RankedSequence<TData, TKey<I>, GetKey<I>, TKeySort<I>>;
+    template<size_t I>
+    using TIndex = typename TKeySpec<I>::template Lookup<TData, TKey<I>, GetKey<I>, TKeySort<I>>;
+    template<size_t I>
+    using TIndexStorage = typename TIndex<I>::Storage;
+
+public:
+    class Builder : public MultiBuilderBase<sizeof...(TKeys)>
+    {
+    private:
+        typedef MultiBuilderBase<sizeof...(TKeys)> Base;
+
+    public:
+        constexpr Builder() : Base(), m_duplicates(), m_weights() {}
+        constexpr explicit Builder(const TDuplicates& duplicates, const TWeights& weights = TWeights()) :
+            Base(),
+            m_duplicates(duplicates),
+            m_weights(weights)
+        {
+        }
+        constexpr explicit Builder(const TWeights& weights) : Base(), m_duplicates(), m_weights(weights) {}
+        ~Builder() = default;
+
+    public:
+        const TDuplicates& getDuplicates() const { return m_duplicates; }
+        const TWeights& getWeights() const { return m_weights; }
+
+    private:
+        TDuplicates m_duplicates;
+        TWeights m_weights;
+    };
+
+public:
+    class Item
+    {
+    public:
+        typedef Item ThisType;
+        typedef Builder TBuilder;
+
+    public:
+        // the keys are given in the order of TKeys
+        template<typename TValParam, typename... TKeyParams>
+        Item(TBuilder& builder, TValParam vp, TKeyParams&&... kps) :
+            m_val(vp),
+            m_keys(std::forward<TKeyParams>(kps)...),
+            m_items{{builder.getUnsortedArray(Is), *this}...}
+        {
+            static_assert(sizeof...(TKeyParams) == sizeof...(TKeys), "an item needs every key");
+        }
+        ~Item() = default;
+
+    private:
+        Item(const Item&) = delete;
+        Item& operator=(const Item&) = delete;
+
+    public:
+        template<size_t I>
+        const TKey<I>& key() const
+        {
+            return std::get<I>(m_keys);
+        }
+        const TVal& val() const { return m_val; }
+
+    private:
+        typedef StructItemT<ThisType> TStructItem;
+
+    private:
+        TVal m_val;
+        std::tuple<TKey<Is>...> m_keys;
+        TStructItem m_items[sizeof...(TKeys)];
+    };
+
+private:
+    template<size_t I>
+    class GetKey
+    {
+    public:
+        static const TKey<I>& key(const TData& item) { return item.template key<I>(); }
+    };
+
+public:
+    explicit MultiIndexMapBase(TBuilder& builder) : m_trees(), m_indexes() { construct(builder); }
+    // the storage of each index, in the order of TKeys
+    MultiIndexMapBase(TBuilder& builder, const TIndexStorage<Is>&... storages) : m_trees(), m_indexes(storages...)
+    {
+        construct(builder);
+    }
+    ~MultiIndexMapBase() = default;
+
+private:
+    MultiIndexMapBase(const MultiIndexMapBase&) = delete;
+    MultiIndexMapBase& operator=(const MultiIndexMapBase&) = delete;
+
+public:
+    template<size_t I>
+    const TData* findKey(const TKey<I>& key) const
+    {
+        const TStructItem* item = static_cast<const TStructItem*>(std::get<I>(m_indexes).find(m_trees[I], key));
+        return item ? &(item->data()) : nullptr;
+    }
+
+    // find keys of other types that TKeySort<I> can compare with the keys,
+    // like findKey of UniMap
+    template<size_t I, typename TOther, typename = EnableIfTransparent<TKeySort<I>, TOther>>
+    const TData* findKey(const TOther& key) const
+    {
+        const TStructItem* item = static_cast<const TStructItem*>(std::get<I>(m_indexes).find(m_trees[I], key));
+        return item ? &(item->data()) : nullptr;
+    }
+
+    // find many keys at once, like findKeys of UniMap
+    template<size_t I>
+    void findKeys(const TKey<I>* keys, size_t count, const TData** items) const
+    {
+        TreeUtil<I>::findKeys(std::get<I>(m_indexes), m_trees[I], keys, count, items);
+    }
+
+public:
+    template<size_t I>
+    TSequence<I> sequence() const
+    {
+        TSequence<I> seq;
+        seq.makeSequence(m_trees[I]);
+        return seq;
+    }
+    // the number of items in the tree of the first key
+    size_t size() const { return m_trees[0].getCount(); }
+
+public:
+    // these find items by their place in the order of key I in O(log n)
+    // time, and work the same as the functions of the same name in
+    // TSequence<I>
+    template<size_t I>
+    TIterator<I> lowerBound(const TKey<I>& key) const
+    {
+        return sequence<I>().lower_bound(key);
+    }
+    template<size_t I>
+    TIterator<I> upperBound(const TKey<I>& key) const
+    {
+        return sequence<I>().upper_bound(key);
+    }
+    template<size_t I>
+    std::pair<TIterator<I>, TIterator<I>> equalRange(const TKey<I>& key) const
+    {
+        return sequence<I>().equal_range(key);
+    }
+    template<size_t I>
+    TSequence<I> range(const TKey<I>& lo, const TKey<I>& hi) const
+    {
+        return sequence<I>().range(lo, hi);
+    }
+    template<size_t I>
+    TSequence<I> findAll(const TKey<I>& key) const
+    {
+        return sequence<I>().range(key);
+    }
+
+private:
+    template<size_t I>
+    int sortKey(TBuilder& builder)
+    {
+        TreeUtil<I>::sortInPlace(builder.getUnsortedArray(I));
+        return 0;
+    }
+
+    // removes the items dropped for another key from the array of key I
+    template<size_t I>
+    int dropFromKey(TBuilder& builder, size_t droppedFor, ItemArray& dropped)
+    {
+        if (I != droppedFor)
+            TreeUtil<I>::removeDropped(builder.getUnsortedArray(I), dropped);
+        return 0;
+    }
+
+    // an item dropped for key I is dropped for every key
+    template<size_t I>
+    int checkKey(TBuilder& builder)
+    {
+        ItemArray dropped;
+        TreeUtil<I>::removeDuplicates(builder.getUnsortedArray(I), builder.getDuplicates(), &dropped);
+        const int done[] = {dropFromKey<Is>(builder, I, dropped)...};
+        (void)done;
+        return 0;
+    }
+
+    template<size_t I>
+    int constructKey(TBuilder& builder)
+    {
+        builder.getWeights().construct(m_trees[I], builder.getUnsortedArray(I));
+        std::get<I>(m_indexes).build(m_trees[I]);
+        return 0;
+    }
+
+    void construct(TBuilder& builder)
+    {
+        // every key is sorted and has its duplicates dropped before any
+        // tree is built, so that every tree has the same items
+        const int sorted[] = {sortKey<Is>(builder)...};
+        (void)sorted;
+        if (builder.getDuplicates().isChecked())
+        {
+            const int checked[] = {checkKey<Is>(builder)...};
+            (void)checked;
+        }
+        const int done[] = {constructKey<Is>(builder)...};
+        (void)done;
+    }
+
+private:
+    ItemTree m_trees[sizeof...(TKeys)];
+    std::tuple<TIndex<Is>...> m_indexes;
+};
+
+template<typename TVal, typename... TKeys>
+using MultiIndexMap = MultiIndexMapBase<TVal, std::make_index_sequence<sizeof...(TKeys)>, TKeys...>;
+
+} // namespace static_map
+
+#endif /* multiindexmap_hpp */
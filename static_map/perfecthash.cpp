@@ -0,0 +1,10 @@
+//
+//  perfecthash.cpp
+//  StaticMap
+//
+
+#include "perfecthash.hpp"
+
+namespace static_map
+{
+}
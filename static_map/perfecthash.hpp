@@ -0,0 +1,476 @@
+//
+//  perfecthash.hpp
+//  StaticMap
+//
+
+#ifndef perfecthash_hpp
+#define perfecthash_hpp
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "itemtree.hpp"
+#include "strref.hpp"
+
+namespace static_map
+{
+
+//
+// KeyHash: the hash used by PerfectHashIndex.  Keys that compare equal under
+// the map's TKeySort must hash the same.  It is specialized for C strings
+// to hash the characters (so it agrees with a strcmp ordering), integers and
+// enums hash their value and anything else uses std::hash.  Specialize it
+// for other key types as needed.  For a map searched with keys of another
+// type through a transparent TKeySort, hash must also take those keys and
+// hash them the same as the equal TKey, otherwise the tree is searched.
+//
+template<typename TKey, typename TEnable = void>
+struct KeyHash
+{
+    static uint64_t hash(const TKey& key) { return static_cast<uint64_t>(std::hash<TKey>()(key)); }
+};
+
+template<typename TKey>
+struct KeyHash<TKey, typename std::enable_if<std::is_integral<TKey>::value || std::is_enum<TKey>::value>::type>
+{
+    static uint64_t hash(const TKey& key) { return static_cast<uint64_t>(static_cast<int64_t>(key)); }
+};
+
+template<>
+struct KeyHash<const char*>
+{
+    // FNV-1a over the characters
+    static uint64_t hash(const char* key)
+    {
+        uint64_t h = 14695981039346656037ULL;
+        for (const unsigned char* c = reinterpret_cast<const unsigned char*>(key); *c; ++c)
+        {
+            h ^= *c;
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+    // the same hash of the characters of a StrRef
+    static uint64_t hash(const StrRef& key)
+    {
+        uint64_t h = 14695981039346656037ULL;
+        const unsigned char* c = reinterpret_cast<const unsigned char*>(key.data());
+        for (size_t i = 0; i < key.size(); ++i)
+        {
+            h ^= c[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+};
+
+//
+// PerfectHashIndex: a lookup index for a map that builds a perfect hash
+// function over the keys once the map is constructed, in the style of
+// PTHash.  The keys are split into buckets by their hash, and each bucket
+// is given a pilot value that moves all of its keys to free slots of the
+// table.  A lookup is then one hash, one read of the bucket's pilot, one
+// read of the table slot, and one check of the key found there.  A key that
+// is not in the map lands on some other key (or an empty slot), fails that
+// check, and gets the default item.
+//
+// The table lives in an array of slots given by the caller, and the same
+// array holds the pilots and everything needed while building, so nothing
+// is allocated:
+//
+// typedef UniMap<int, const char*, std::less<int>, PerfectHashIndex> M;
+// static M::TIndex::Slot s_slots[M::TIndex::slotsFor(1000)];
+// static M s_map(s_builder, s_slots);
+//
+// If the array is too small, or no pilots can be found, the map will search
+// the tree instead.
+//
+template<typename TData, typename TKey, typename TKeyGet, typename TKeySort>
+class PerfectHashIndex
+{
+private:
+    typedef StructItemT<TData> TStructItem;
+    typedef TreeFuncs<TData, TKey, TKeyGet, TKeySort> TreeUtil;
+    typedef KeyHash<TKey> THash;
+
+public:
+    // a slot of the table, also used for the pilot of the bucket with the
+    // same number.  while building, the hashes of the items are kept where
+    // the items will go, and the temp holds the items grouped by bucket and
+    // whether the slot is taken
+    struct Slot
+    {
+        union {
+            const StructItem* m_item;
+            uint64_t m_hash;
+        };
+        uint32_t m_pilot;
+        uint32_t m_temp;
+    };
+
+    // the caller supplied array of slots
+    class Storage
+    {
+    public:
+        Storage() : m_slots(nullptr), m_capacity(0) {}
+        template<size_t N>
+        Storage(Slot (&slots)[N]) : m_slots(slots), m_capacity(N)
+        {
+        }
+        Storage(Slot* slots, size_t capacity) : m_slots(slots), m_capacity(capacity) {}
+
+    public:
+        Slot* slots() const { return m_slots; }
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        Slot* m_slots;
+        size_t m_capacity;
+    };
+
+public:
+    PerfectHashIndex() : m_storage(), m_tableSize(0), m_bucketCount(0), m_seed(0) {}
+    explicit PerfectHashIndex(const Storage& storage) :
+        m_storage(storage),
+        m_tableSize(0),
+        m_bucketCount(0),
+        m_seed(0)
+    {
+    }
+    ~PerfectHashIndex() = default;
+
+private:
+    PerfectHashIndex(const PerfectHashIndex&) = delete;
+    PerfectHashIndex& operator=(const PerfectHashIndex&) = delete;
+
+public:
+    // the number of slots needed for count keys, which keeps the table at
+    // most 80% full so that pilots are quick to find
+    static constexpr size_t slotsFor(size_t count) { return count + count / 4 + 1; }
+    // returns true if the table is being used for lookups
+    bool isBuilt() const { return m_tableSize != 0; }
+
+public:
+    // builds the table in about O(n) time if there is room
+    void build(const ItemTree& tree)
+    {
+        assert(!m_tableSize);
+        const size_t count = tree.hasRepeats() ? keyCount(tree) : tree.getCount();
+        const size_t tableSize = slotsFor(count);
+        if (count == 0 || tableSize > m_storage.capacity() || count >= s_taken)
+            return;
+        // about four keys per bucket
+        const size_t bucketCount = count / 4 + 1;
+        for (uint64_t seed = 1; seed <= s_maxSeeds; ++seed)
+        {
+            if (tryBuild(tree, count, tableSize, bucketCount, seed))
+            {
+                m_tableSize = tableSize;
+                m_bucketCount = bucketCount;
+                m_seed = seed;
+                return;
+            }
+        }
+    }
+
+    // finds the key in O(1) time, returns the default item if not found
+    const StructItem* find(const ItemTree& tree, const TKey& key) const { return search(tree, key); }
+    // finds a key of another type that TKeySort can compare with the keys,
+    // in O(1) time if THash can hash it, otherwise by searching the tree
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    const StructItem* find(const ItemTree& tree, const TOther& key) const
+    {
+        return findOther(tree, key, IsHashable<TOther>());
+    }
+
+    // does find for up to s_batchSize keys at once.  each of the three reads
+    // of a lookup (the pilot, the slot, and the key) is done for every key
+    // before any of the next, with the reads of the next step prefetched
+    void findMany(const ItemTree& tree, const TKey* keys, size_t count, const StructItem** items) const
+    {
+        if (!m_tableSize)
+        {
+            TreeUtil::findManyInTree(tree, keys, count, items);
+            return;
+        }
+
+        assert(count <= TreeUtil::s_batchSize);
+        const Slot* slots = m_storage.slots();
+        uint64_t hashes[TreeUtil::s_batchSize];
+        for (size_t i = 0; i < count; ++i)
+        {
+            hashes[i] = hashOf(keys[i], m_seed);
+            STATIC_MAP_PREFETCH(slots + bucketOf(hashes[i], m_bucketCount));
+        }
+        size_t positions[TreeUtil::s_batchSize];
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32_t pilot = slots[bucketOf(hashes[i], m_bucketCount)].m_pilot;
+            positions[i] = positionOf(hashes[i], pilot, m_tableSize);
+            STATIC_MAP_PREFETCH(slots + positions[i]);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            items[i] = slots[positions[i]].m_item;
+            if (items[i])
+                STATIC_MAP_PREFETCH(items[i]);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            items[i] = itemIfMatch(tree, items[i], keys[i]);
+        }
+    }
+
+private:
+    // true if THash can hash a TOther
+    template<typename TOther, typename TEnable = void>
+    struct IsHashable : std::false_type
+    {
+    };
+
+    template<typename TOther>
+    struct IsHashable<TOther, typename MakeVoid<decltype(THash::hash(std::declval<const TOther&>()))>::type> :
+        std::true_type
+    {
+    };
+
+    template<typename TSearch>
+    const StructItem* search(const ItemTree& tree, const TSearch& key) const
+    {
+        if (!m_tableSize)
+            return TreeUtil::findInTree(tree, key);
+
+        const Slot* slots = m_storage.slots();
+        const uint64_t h = hashOf(key, m_seed);
+        const uint32_t pilot = slots[bucketOf(h, m_bucketCount)].m_pilot;
+        return itemIfMatch(tree, slots[positionOf(h, pilot, m_tableSize)].m_item, key);
+    }
+
+    template<typename TOther>
+    const StructItem* findOther(const ItemTree& tree, const TOther& key, std::true_type) const
+    {
+        return search(tree, key);
+    }
+
+    template<typename TOther>
+    const StructItem* findOther(const ItemTree& tree, const TOther& key, std::false_type) const
+    {
+        return TreeUtil::findInTree(tree, key);
+    }
+
+    static const TKey& keyOf(const StructItem* item)
+    {
+        return TKeyGet::key(static_cast<const TStructItem*>(item)->data());
+    }
+
+    // the next item with a different key, so that only the first item with
+    // each key is put in the table when the tree has repeats
+    static const StructItem* nextKey(const ItemTree& tree, const StructItem* item)
+    {
+        const StructItem* next = tree.getNext(item);
+        if (tree.hasRepeats())
+        {
+            TKeySort compare;
+            while (next && !compare(keyOf(item), keyOf(next)))
+                next = tree.getNext(next);
+        }
+        return next;
+    }
+
+    // the number of different keys in the tree
+    static size_t keyCount(const ItemTree& tree)
+    {
+        size_t count = 0;
+        for (const StructItem* item = tree.getFirst(); item; item = nextKey(tree, item))
+            ++count;
+        return count;
+    }
+
+    // the item if it has the key, otherwise the default item
+    template<typename TSearch>
+    static const StructItem* itemIfMatch(const ItemTree& tree, const StructItem* item, const TSearch& key)
+    {
+        if (item)
+        {
+            const TKey& itemKey = keyOf(item);
+            TKeySort compare;
+            if (!compare(key, itemKey) && !compare(itemKey, key))
+                return item;
+        }
+        return tree.getDefault();
+    }
+
+    // mix the bits so that every bit of the hash affects the result
+    static uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    template<typename TSearch>
+    static uint64_t hashOf(const TSearch& key, uint64_t seed) { return mix(THash::hash(key) ^ (seed * 0x9e3779b97f4a7c15ULL)); }
+
+    // maps 32 bits of hash onto [0, range) without a division
+    static size_t reduce(uint32_t h, size_t range)
+    {
+        return static_cast<size_t>((static_cast<uint64_t>(h) * static_cast<uint64_t>(range)) >> 32);
+    }
+
+    static size_t bucketOf(uint64_t h, size_t bucketCount) { return reduce(static_cast<uint32_t>(h >> 32), bucketCount); }
+
+    static size_t positionOf(uint64_t h, uint32_t pilot, size_t tableSize)
+    {
+        return reduce(static_cast<uint32_t>(mix(h ^ (pilot * 0x9e3779b97f4a7c15ULL))), tableSize);
+    }
+
+    // attempts to find pilots for every bucket using the seed, and fills
+    // in the table if it succeeds
+    bool tryBuild(const ItemTree& tree, size_t count, size_t tableSize, size_t bucketCount, uint64_t seed)
+    {
+        Slot* slots = m_storage.slots();
+        for (size_t i = 0; i < tableSize; ++i)
+        {
+            slots[i].m_hash = 0;
+            slots[i].m_pilot = 0;
+            slots[i].m_temp = 0;
+        }
+
+        // keep the hash of each item by its position in order, and count
+        // the items in each bucket in the pilot
+        size_t i = 0;
+        for (const StructItem* item = tree.getFirst(); item; item = nextKey(tree, item), ++i)
+        {
+            const uint64_t h = hashOf(keyOf(item), seed);
+            slots[i].m_hash = h;
+            ++slots[bucketOf(h, bucketCount)].m_pilot;
+        }
+        assert(i == count);
+
+        // the biggest buckets are the hardest to place, so do them first.
+        // count how many buckets there are of each size to find where each
+        // size starts, then give each bucket its place within its size.
+        size_t sizeStarts[s_maxBucket + 1] = {};
+        for (size_t b = 0; b < bucketCount; ++b)
+        {
+            const uint32_t size = slots[b].m_pilot;
+            if (size > s_maxBucket)
+                return false;
+            sizeStarts[size] += size;
+        }
+        size_t start = 0;
+        for (size_t size = s_maxBucket; size > 0; --size)
+        {
+            const size_t items = sizeStarts[size];
+            sizeStarts[size] = start;
+            start += items;
+        }
+        for (size_t b = 0; b < bucketCount; ++b)
+        {
+            const uint32_t size = slots[b].m_pilot;
+            slots[b].m_pilot = static_cast<uint32_t>(sizeStarts[size]);
+            sizeStarts[size] += size;
+        }
+        // now put each item number where its bucket starts
+        for (i = 0; i < count; ++i)
+        {
+            Slot& bucket = slots[bucketOf(slots[i].m_hash, bucketCount)];
+            slots[bucket.m_pilot].m_temp = static_cast<uint32_t>(i);
+            ++bucket.m_pilot;
+        }
+        for (size_t b = 0; b < bucketCount; ++b)
+        {
+            slots[b].m_pilot = 0;
+        }
+
+        // find a pilot for each bucket that puts all of its items into
+        // slots that are not taken.  the items of a bucket are together
+        // in the temp, so each bucket ends where the bucket number changes
+        size_t first = 0;
+        while (first < count)
+        {
+            const size_t bucket = bucketOf(slots[slots[first].m_temp & s_itemMask].m_hash, bucketCount);
+            size_t last = first + 1;
+            while (last < count && bucketOf(slots[slots[last].m_temp & s_itemMask].m_hash, bucketCount) == bucket)
+                ++last;
+            if (!placeBucket(slots, first, last, bucket, tableSize))
+                return false;
+            first = last;
+        }
+
+        // the hashes are not needed anymore, so replace them with the items
+        // in the slots that their pilots chose
+        for (i = 0; i < tableSize; ++i)
+        {
+            slots[i].m_item = nullptr;
+            slots[i].m_temp = 0;
+        }
+        for (const StructItem* item = tree.getFirst(); item; item = nextKey(tree, item))
+        {
+            const uint64_t h = hashOf(keyOf(item), seed);
+            Slot& slot = slots[positionOf(h, slots[bucketOf(h, bucketCount)].m_pilot, tableSize)];
+            assert(!slot.m_item);
+            slot.m_item = item;
+        }
+        return true;
+    }
+
+    // tries pilots until the items first to last all go to free slots,
+    // then marks those slots as taken
+    bool placeBucket(Slot* slots, size_t first, size_t last, size_t bucket, size_t tableSize)
+    {
+        for (uint32_t pilot = 0; pilot < s_maxPilot; ++pilot)
+        {
+            size_t placed = first;
+            for (; placed < last; ++placed)
+            {
+                const uint64_t h = slots[slots[placed].m_temp & s_itemMask].m_hash;
+                Slot& slot = slots[positionOf(h, pilot, tableSize)];
+                if (slot.m_temp & s_taken)
+                    break;
+                // taken for now, so that the bucket cannot collide with itself
+                slot.m_temp |= s_taken;
+            }
+            if (placed == last)
+            {
+                slots[bucket].m_pilot = pilot;
+                return true;
+            }
+            // undo the slots taken by this pilot
+            for (size_t undo = first; undo < placed; ++undo)
+            {
+                const uint64_t h = slots[slots[undo].m_temp & s_itemMask].m_hash;
+                slots[positionOf(h, pilot, tableSize)].m_temp &= ~s_taken;
+            }
+        }
+        return false;
+    }
+
+private:
+    // the bit of the temp that marks a slot as taken, and the rest of it
+    static const uint32_t s_taken = 0x80000000u;
+    static const uint32_t s_itemMask = 0x7fffffffu;
+    // a bucket bigger than this means that the hash is not working out
+    static const size_t s_maxBucket = 64;
+    // how long to look for a pilot for a bucket before trying a new seed
+    static const uint32_t s_maxPilot = 1u << 20;
+    // how many seeds to try before giving up on the table
+    static const uint64_t s_maxSeeds = 8;
+
+private:
+    Storage m_storage;
+    size_t m_tableSize;
+    size_t m_bucketCount;
+    uint64_t m_seed;
+};
+
+} // namespace static_map
+
+#endif /* perfecthash_hpp */
@@ -0,0 +1,10 @@
+//
+//  radixmap.cpp
+//  StaticMap
+//
+
+#include "radixmap.hpp"
+
+namespace static_map
+{
+}
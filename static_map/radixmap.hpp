@@ -0,0 +1,452 @@
+//
+//  radixmap.hpp
+//  StaticMap
+//
+
+#ifndef radixmap_hpp
+#define radixmap_hpp
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "builderbase.hpp"
+#include "itemtree.hpp"
+#include "sequence.hpp"
+#include "strref.hpp"
+
+namespace static_map
+{
+
+//
+// RadixMap: a map with C string keys that, besides finding a key, finds
+// all of the keys that start with some text (like the commands that an
+// abbreviation could be) and the longest key that the text starts with
+// (like the route for a path).  It is made with a Builder and Items like a
+// UniMap, and its items are kept in a tree in StrLess order for sequence.
+// The lookups go down a radix tree, where each node holds the characters
+// that all of the keys under it share, so they take time in the length of
+// the text rather than log n string compares.
+//
+// The nodes of the radix tree live in an array given by the caller, and
+// nothing is allocated:
+//
+// typedef RadixMap<Handler> M;
+// static M::Builder s_builder;
+// static M::Item s_iGet(s_builder, "get", &onGet);
+// static M::Item s_iGetAll(s_builder, "getall", &onGetAll);
+// static M::Node s_nodes[M::nodesFor(2)];
+// static M s_map(s_builder, s_nodes);
+//
+// M::TSequence seq = s_map.prefixRange("ge"); // get, getall
+// const M::Item* i = s_map.longestMatch("getallnow"); // getall
+//
+// If the array is too small, findKey searches the tree, and prefixRange
+// and longestMatch go through the items.
+//
+template<typename TVal>
+class RadixMap
+{
+public:
+    class Item;
+    class Builder;
+    struct Node;
+    class Storage;
+    typedef RadixMap<TVal> ThisType;
+    typedef Builder TBuilder;
+    typedef Item TData;
+    typedef DuplicatePolicy<TData> TDuplicates;
+    typedef const char* TKey;
+    typedef StrLess TKeySort;
+
+private:
+    class GetKey;
+    typedef StructItemT<TData> TStructItem;
+    typedef GetKey TKeyGet;
+    typedef TreeFuncs<TData, TKey, TKeyGet, TKeySort> TreeUtil;
+
+public:
+    typedef Sequence<TData, TKey, TKeyGet, TKeySort> TSequence;
+    typedef typename TSequence::const_iterator TIterator;
+
+public:
+    //
+    // Builder is the class used to build a map, as for a UniMap
+    //
+    class Builder : public BuilderBase
+    {
+    private:
+        typedef BuilderBase Base;
+
+    public:
+        constexpr Builder() : Base(), m_duplicates() {}
+        constexpr explicit Builder(const TDuplicates& duplicates) : Base(), m_duplicates(duplicates) {}
+        ~Builder() = default;
+
+    public:
+        const TDuplicates& getDuplicates() const { return m_duplicates; }
+
+    private:
+        TDuplicates m_duplicates;
+    };
+
+public:
+    //
+    // Item is an item in a RadixMap, holding the key and TVal instance.
+    // Create one of these as a static instance using a Builder.
+    //
+    class Item
+    {
+    public:
+        typedef Item ThisType;
+        typedef Builder TBuilder;
+
+    public:
+        template<typename TValParam>
+        Item(TBuilder& builder, const char* key, TValParam vp, bool isDefault = false) :
+            m_item(builder.getUnsortedArray(), *this),
+            m_key(key),
+            m_val(vp)
+        {
+            assert(key);
+            if (isDefault)
+            {
+                builder.getUnsortedArray().setDefault(m_item);
+            }
+        }
+        ~Item() = default;
+
+    private:
+        Item(const Item&) = delete;
+        Item& operator=(const Item&) = delete;
+
+    public:
+        const TKey& key() const { return m_key; }
+        const TVal& val() const { return m_val; }
+
+    private:
+        TStructItem m_item;
+        TKey m_key;
+        TVal m_val;
+    };
+
+public:
+    //
+    // Node is a node of the radix tree.  Its label is the characters from
+    // its parent to it, and its children are next to each other in the
+    // array, in the order of the first characters of their labels.
+    //
+    struct Node
+    {
+        // the characters, which are in the key of one of the items
+        const char* m_label;
+        // the item whose key ends here, or nullptr
+        const StructItem* m_item;
+        // the first and last items under the node
+        const StructItem* m_first;
+        const StructItem* m_last;
+        uint32_t m_labelSize;
+        uint32_t m_firstChild;
+        uint32_t m_childCount;
+    };
+
+    // the caller supplied array of nodes
+    class Storage
+    {
+    public:
+        Storage() : m_nodes(nullptr), m_capacity(0) {}
+        template<size_t N>
+        Storage(Node (&nodes)[N]) : m_nodes(nodes), m_capacity(N)
+        {
+        }
+        Storage(Node* nodes, size_t capacity) : m_nodes(nodes), m_capacity(capacity) {}
+
+    public:
+        Node* nodes() const { return m_nodes; }
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        Node* m_nodes;
+        size_t m_capacity;
+    };
+
+private:
+    class GetKey
+    {
+    public:
+        static const TKey& key(const TData& item) { return item.key(); }
+    };
+
+public:
+    RadixMap(TBuilder& builder, const Storage& storage = Storage()) : m_tree(), m_storage(storage), m_nodeCount(0)
+    {
+        ItemArray& array = builder.getUnsortedArray();
+        TreeUtil::sortInPlace(array);
+        if (builder.getDuplicates().isChecked())
+            TreeUtil::removeDuplicates(array, builder.getDuplicates());
+        m_tree.constructFrom(array);
+        build();
+    }
+    ~RadixMap() = default;
+
+private:
+    RadixMap(const RadixMap&) = delete;
+    RadixMap& operator=(const RadixMap&) = delete;
+
+public:
+    // the number of nodes needed for count keys.  every node but the root
+    // either ends a key or has at least two children, so there are at most
+    // two for each key
+    static constexpr size_t nodesFor(size_t count) { return 2 * count + 1; }
+    // returns true if the radix tree is being used for lookups
+    bool isBuilt() const { return m_nodeCount != 0; }
+
+public:
+    // finds the key in time in its length, returns the default item (or
+    // nullptr) if not found
+    const TData* findKey(const StrRef& key) const
+    {
+        const StructItem* item = nullptr;
+        if (m_nodeCount)
+        {
+            const Node* node = descend(key, false);
+            item = (node && node->m_item) ? node->m_item : m_tree.getDefault();
+        }
+        else
+        {
+            item = TreeUtil::findInTree(m_tree, key);
+        }
+        return dataOf(item);
+    }
+
+    // makes a Sequence of the items whose keys start with the prefix, in
+    // time in the length of the prefix
+    TSequence prefixRange(const StrRef& prefix) const
+    {
+        const StructItem* first = nullptr;
+        const StructItem* last = nullptr;
+        if (m_nodeCount)
+        {
+            const Node* node = descend(prefix, true);
+            if (node)
+            {
+                first = node->m_first;
+                last = node->m_last;
+            }
+        }
+        else
+        {
+            for (const StructItem* item = m_tree.getFirst(); item; item = m_tree.getNext(item))
+            {
+                if (startsWith(TreeUtil::keyOf(item), prefix))
+                {
+                    first = first ? first : item;
+                    last = item;
+                }
+            }
+        }
+        TSequence seq;
+        seq.makeSequence(m_tree, first, last ? m_tree.getNext(last) : nullptr);
+        return seq;
+    }
+
+    // finds the item with the longest key that the text starts with, in
+    // time in the length of the text, returns nullptr if there is none
+    const TData* longestMatch(const StrRef& text) const
+    {
+        const StructItem* best = nullptr;
+        size_t bestSize = 0;
+        if (m_nodeCount)
+        {
+            const Node* node = m_storage.nodes();
+            best = node->m_item;
+            size_t pos = 0;
+            while (pos < text.size())
+            {
+                node = childOf(*node, text.data()[pos]);
+                if (!node || node->m_labelSize > text.size() - pos ||
+                    memcmp(node->m_label, text.data() + pos, node->m_labelSize) != 0)
+                    break;
+                pos += node->m_labelSize;
+                if (node->m_item)
+                    best = node->m_item;
+            }
+        }
+        else
+        {
+            for (const StructItem* item = m_tree.getFirst(); item; item = m_tree.getNext(item))
+            {
+                const char* key = TreeUtil::keyOf(item);
+                const size_t size = strlen(key);
+                if ((!best || size > bestSize) && startsWith(text, StrRef(key, size)))
+                {
+                    best = item;
+                    bestSize = size;
+                }
+            }
+        }
+        return dataOf(best);
+    }
+
+public:
+    TSequence sequence() const
+    {
+        TSequence seq;
+        seq.makeSequence(m_tree);
+        return seq;
+    }
+    size_t size() const { return m_tree.getCount(); }
+
+private:
+    static const TData* dataOf(const StructItem* item)
+    {
+        return item ? &(static_cast<const TStructItem*>(item)->data()) : nullptr;
+    }
+
+    static bool startsWith(const StrRef& text, const StrRef& prefix)
+    {
+        return text.size() >= prefix.size() && memcmp(text.data(), prefix.data(), prefix.size()) == 0;
+    }
+
+    // finds the child of the node whose label starts with the character,
+    // returns nullptr if there is none
+    const Node* childOf(const Node& node, char c) const
+    {
+        const unsigned char u = static_cast<unsigned char>(c);
+        const Node* lo = m_storage.nodes() + node.m_firstChild;
+        size_t count = node.m_childCount;
+        while (count > 0)
+        {
+            const size_t step = count / 2;
+            const Node* middle = lo + step;
+            if (static_cast<unsigned char>(middle->m_label[0]) < u)
+            {
+                lo = middle + 1;
+                count -= step + 1;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+        const Node* end = m_storage.nodes() + node.m_firstChild + node.m_childCount;
+        return (lo != end && static_cast<unsigned char>(lo->m_label[0]) == u) ? lo : nullptr;
+    }
+
+    // follows the text down from the root, returns the node where it ends,
+    // or nullptr if no key goes that way.  if isPrefix, the text may end
+    // part way through the label of the node
+    const Node* descend(const StrRef& text, bool isPrefix) const
+    {
+        const Node* node = m_storage.nodes();
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            node = childOf(*node, text.data()[pos]);
+            if (!node)
+                return nullptr;
+            size_t size = node->m_labelSize;
+            if (size > text.size() - pos)
+            {
+                if (!isPrefix)
+                    return nullptr;
+                size = text.size() - pos;
+            }
+            if (memcmp(node->m_label, text.data() + pos, size) != 0)
+                return nullptr;
+            pos += size;
+        }
+        return node;
+    }
+
+private:
+    // fills the nodes from the sorted items in O(n * length) time if there
+    // is room
+    void build()
+    {
+        assert(!m_nodeCount);
+        if (m_tree.getCount() == 0 || m_storage.capacity() == 0)
+            return;
+        Node& root = m_storage.nodes()[0];
+        root.m_label = "";
+        root.m_labelSize = 0;
+        size_t next = 1;
+        if (buildNode(root, m_tree.getFirst(), m_tree.getLast(), 0, next))
+            m_nodeCount = next;
+    }
+
+    // fills the node for the items from first to last, whose keys all start
+    // with the same depth characters, and puts its children in the nodes
+    // from next on.  returns false if there are not enough nodes
+    bool buildNode(Node& node, const StructItem* first, const StructItem* last, size_t depth, size_t& next)
+    {
+        node.m_item = nullptr;
+        node.m_first = first;
+        node.m_last = last;
+        node.m_firstChild = static_cast<uint32_t>(next);
+        node.m_childCount = 0;
+
+        // the keys that end here sort first, and the first of them is the
+        // one that is found
+        const StructItem* end = m_tree.getNext(last);
+        const StructItem* item = first;
+        if (TreeUtil::keyOf(item)[depth] == 0)
+        {
+            node.m_item = item;
+            while (item != end && TreeUtil::keyOf(item)[depth] == 0)
+            {
+                item = m_tree.getNext(item);
+            }
+        }
+
+        // there is a child for each character that the rest go on with
+        size_t childCount = 0;
+        for (const StructItem* it = item; it != end; it = m_tree.getNext(it))
+        {
+            if (it == item || TreeUtil::keyOf(it)[depth] != TreeUtil::keyOf(m_tree.getPrev(it))[depth])
+                ++childCount;
+        }
+        if (childCount > m_storage.capacity() - next)
+            return false;
+        node.m_childCount = static_cast<uint32_t>(childCount);
+        size_t child = next;
+        next += childCount;
+
+        while (item != end)
+        {
+            // the keys from item to groupLast go on with the same character,
+            // and the child gets all of the characters that they share
+            const char c = TreeUtil::keyOf(item)[depth];
+            const StructItem* groupLast = item;
+            for (const StructItem* it = m_tree.getNext(item); it != end && TreeUtil::keyOf(it)[depth] == c;
+                 it = m_tree.getNext(it))
+            {
+                groupLast = it;
+            }
+            const char* label = TreeUtil::keyOf(item) + depth;
+            const char* lastLabel = TreeUtil::keyOf(groupLast) + depth;
+            size_t shared = 0;
+            while (label[shared] != 0 && label[shared] == lastLabel[shared])
+            {
+                ++shared;
+            }
+            Node& childNode = m_storage.nodes()[child++];
+            childNode.m_label = label;
+            childNode.m_labelSize = static_cast<uint32_t>(shared);
+            if (!buildNode(childNode, item, groupLast, depth + shared, next))
+                return false;
+            item = m_tree.getNext(groupLast);
+        }
+        return true;
+    }
+
+private:
+    ItemTree m_tree;
+    Storage m_storage;
+    size_t m_nodeCount;
+};
+
+} // namespace static_map
+
+#endif /* radixmap_hpp */
@@ -0,0 +1,10 @@
+//
+//  ranked.cpp
+//  StaticMap
+//
+
+#include "ranked.hpp"
+
+namespace static_map
+{
+}
@@ -0,0 +1,234 @@
+//
+//  ranked.hpp
+//  StaticMap
+//
+
+#ifndef ranked_hpp
+#define ranked_hpp
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+
+#include "sequence.hpp"
+
+namespace static_map
+{
+
+//
+// RankedSequence: the items of a Sequence copied in order into an array
+// given by the caller, so that items can be found by their place in the
+// order.  nth(k) is O(1), rank(key) is a binary search of the array in
+// O(log n), and the const_iterator is random access, so that a page of the
+// items, or the key at some percentile, is cheap to get:
+//
+// typedef UniMap<int, const char*> M;
+// static M::TRanked::Slot s_slots[1000];
+// static M::TRanked s_ranked(s_map.sequence(), s_slots);
+// ...
+// const M::Item& median = s_ranked.nth(s_ranked.size() / 2);
+//
+// Any Sequence can be ranked, like a range of a map or one key of a BiMap.
+// The array is filled in O(n) time when the RankedSequence is constructed.
+// If it is too small, it is not used, and nth and rank step through the
+// Sequence instead in O(n) time.
+//
+template<typename TData, typename TKey, typename TKeyGet, typename TKeySort>
+class RankedSequence
+{
+public:
+    typedef RankedSequence<TData, TKey, TKeyGet, TKeySort> ThisType;
+    typedef Sequence<TData, TKey, TKeyGet, TKeySort> TSequence;
+    // a slot of the array, which holds one item
+    typedef const TData* Slot;
+
+    // the caller supplied array of slots
+    class Storage
+    {
+    public:
+        Storage() : m_slots(nullptr), m_capacity(0) {}
+        template<size_t N>
+        Storage(Slot (&slots)[N]) : m_slots(slots), m_capacity(N)
+        {
+        }
+        Storage(Slot* slots, size_t capacity) : m_slots(slots), m_capacity(capacity) {}
+
+    public:
+        Slot* slots() const { return m_slots; }
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        Slot* m_slots;
+        size_t m_capacity;
+    };
+
+public:
+    class const_iterator : public std::iterator<std::random_access_iterator_tag, TData>
+    {
+    public:
+        typedef const_iterator ThisType;
+        typedef ptrdiff_t TDiff;
+
+    public:
+        const_iterator() : m_ranked(nullptr), m_pos(0) {}
+        const_iterator(const RankedSequence& ranked, size_t pos) : m_ranked(&ranked), m_pos(pos) {}
+        ~const_iterator() = default;
+        const_iterator(const const_iterator& rhs) = default;
+        const_iterator& operator=(const const_iterator& rhs) = default;
+
+    public:
+        const_iterator& operator++()
+        {
+            ++m_pos;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            ThisType temp = *this;
+            ++m_pos;
+            return temp;
+        }
+        const_iterator& operator--()
+        {
+            --m_pos;
+            return *this;
+        }
+        const_iterator operator--(int)
+        {
+            ThisType temp = *this;
+            --m_pos;
+            return temp;
+        }
+        const_iterator& operator+=(TDiff n)
+        {
+            m_pos += n;
+            return *this;
+        }
+        const_iterator& operator-=(TDiff n)
+        {
+            m_pos -= n;
+            return *this;
+        }
+        const_iterator operator+(TDiff n) const { return ThisType(*m_ranked, m_pos + n); }
+        const_iterator operator-(TDiff n) const { return ThisType(*m_ranked, m_pos - n); }
+        friend const_iterator operator+(TDiff n, const const_iterator& it) { return it + n; }
+        TDiff operator-(const const_iterator& rhs) const
+        {
+            return static_cast<TDiff>(m_pos) - static_cast<TDiff>(rhs.m_pos);
+        }
+
+    public:
+        bool operator==(const const_iterator& rhs) const { return m_pos == rhs.m_pos && m_ranked == rhs.m_ranked; }
+        bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+        bool operator<(const const_iterator& rhs) const { return m_pos < rhs.m_pos; }
+        bool operator>(const const_iterator& rhs) const { return m_pos > rhs.m_pos; }
+        bool operator<=(const const_iterator& rhs) const { return m_pos <= rhs.m_pos; }
+        bool operator>=(const const_iterator& rhs) const { return m_pos >= rhs.m_pos; }
+
+    public:
+        const TData* operator->() const { return &m_ranked->nth(m_pos); }
+        const TData& operator*() const { return m_ranked->nth(m_pos); }
+        const TData& operator[](TDiff n) const { return m_ranked->nth(m_pos + n); }
+
+    private:
+        const RankedSequence* m_ranked;
+        size_t m_pos;
+    };
+
+public:
+    explicit RankedSequence(const TSequence& seq, const Storage& storage = Storage()) :
+        m_seq(seq),
+        m_slots(nullptr),
+        m_count(0)
+    {
+        for (typename TSequence::const_iterator it = seq.begin(); it != seq.end(); ++it)
+        {
+            ++m_count;
+        }
+        if (m_count == 0 || m_count > storage.capacity())
+            return;
+        m_slots = storage.slots();
+        size_t k = 0;
+        for (typename TSequence::const_iterator it = seq.begin(); it != seq.end(); ++it)
+        {
+            m_slots[k++] = &*it;
+        }
+    }
+    ~RankedSequence() = default;
+    RankedSequence(const RankedSequence& rhs) = default;
+    RankedSequence& operator=(const RankedSequence& rhs) = default;
+
+public:
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    // returns true if the array is being used
+    bool isBuilt() const { return m_slots != nullptr; }
+
+public:
+    // gets the item at place k of the order, k must be less than size()
+    const TData& nth(size_t k) const
+    {
+        assert(k < m_count);
+        if (m_slots)
+            return *m_slots[k];
+        typename TSequence::const_iterator it = m_seq.begin();
+        while (k--)
+            ++it;
+        return *it;
+    }
+
+    // gets the number of items whose keys are less than the key, which is
+    // the place of the first item with the key if there is one
+    size_t rank(const TKey& key) const { return boundOf(key, false); }
+
+    // these find items by their place in the order in O(log n) time, like
+    // the functions of the same name in TSequence
+    const_iterator lower_bound(const TKey& key) const { return const_iterator(*this, boundOf(key, false)); }
+    const_iterator upper_bound(const TKey& key) const { return const_iterator(*this, boundOf(key, true)); }
+
+public:
+    const_iterator begin() const { return const_iterator(*this, 0); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator end() const { return const_iterator(*this, m_count); }
+    const_iterator cend() const { return end(); }
+
+private:
+    // the number of items whose keys are less than the key, or with upper,
+    // not greater than the key
+    size_t boundOf(const TKey& key, bool upper) const
+    {
+        TKeySort compare;
+        if (!m_slots)
+        {
+            size_t k = 0;
+            for (typename TSequence::const_iterator it = m_seq.begin(); it != m_seq.end(); ++it, ++k)
+            {
+                const TKey& itemKey = TKeyGet::key(*it);
+                if (upper ? compare(key, itemKey) : !compare(itemKey, key))
+                    break;
+            }
+            return k;
+        }
+        size_t lo = 0;
+        size_t hi = m_count;
+        while (lo < hi)
+        {
+            const size_t mid = lo + (hi - lo) / 2;
+            const TKey& itemKey = TKeyGet::key(*m_slots[mid]);
+            if (upper ? !compare(key, itemKey) : compare(itemKey, key))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+private:
+    TSequence m_seq;
+    Slot* m_slots;
+    size_t m_count;
+};
+
+} // namespace static_map
+
+#endif /* ranked_hpp */
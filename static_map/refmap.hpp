@@ -12,8 +12,14 @@
 #include <functional>
 
 #include "builderbase.hpp"
+#include "denseindex.hpp"
+#include "eytzinger.hpp"
 #include "itemtree.hpp"
+#include "mapstats.hpp"
+#include "perfecthash.hpp"
+#include "ranked.hpp"
 #include "sequence.hpp"
+#include "stree.hpp"
 
 namespace static_map
 {
@@ -28,19 +34,27 @@ public:
 //
 //
 
-template<typename TData, typename TKey, typename TKeyGet = RefGetKey<TData, TKey>, typename TKeySort = std::less<TKey>>
+template<typename TData, typename TKey, typename TKeyGet = RefGetKey<TData, TKey>, typename TKeySort = std::less<TKey>,
+         template<typename, typename, typename, typename> class TLookup = TreeIndex, typename TStats = NoStats>
 class RefMap
 {
 public:
     class Item;
     class Builder;
-    typedef RefMap<TData, TKey, TKeyGet, TKeySort> ThisType;
+    typedef RefMap<TData, TKey, TKeyGet, TKeySort, TLookup, TStats> ThisType;
     typedef Builder TBuilder;
     typedef Sequence<TData, TKey, TKeyGet, TKeySort> TSequence;
+    typedef typename TSequence::const_iterator TIterator;
+    typedef RankedSequence<TData, TKey, TKeyGet, TKeySort> TRanked;
+    typedef TLookup<TData, TKey, TKeyGet, TKeySort> TIndex;
+    typedef typename TIndex::Storage TIndexStorage;
+    typedef DuplicatePolicy<TData> TDuplicates;
+    typedef WeightPolicy<TData> TWeights;
 
 private:
     typedef TreeFuncs<TData, TKey, TKeyGet, TKeySort> TreeUtil;
     typedef StructItemT<TData> TStructItem;
+    typedef StatsFuncs<TreeUtil, TIndex, TStats> StatsUtil;
 
 public:
     class Builder : public BuilderBase
@@ -49,8 +63,23 @@ public:
         typedef BuilderBase Base;
 
     public:
-        Builder() : Base() {}
+        constexpr Builder() : Base(), m_duplicates(), m_weights() {}
+        constexpr explicit Builder(const TDuplicates& duplicates, const TWeights& weights = TWeights()) :
+            Base(),
+            m_duplicates(duplicates),
+            m_weights(weights)
+        {
+        }
+        constexpr explicit Builder(const TWeights& weights) : Base(), m_duplicates(), m_weights(weights) {}
         ~Builder() = default;
+
+    public:
+        const TDuplicates& getDuplicates() const { return m_duplicates; }
+        const TWeights& getWeights() const { return m_weights; }
+
+    private:
+        TDuplicates m_duplicates;
+        TWeights m_weights;
     };
 
 public:
@@ -83,11 +112,17 @@ public:
     };
 
 public:
-    RefMap(TBuilder& builder) : m_tree()
+    RefMap(TBuilder& builder, const TIndexStorage& storage = TIndexStorage(), const char* statsName = nullptr) :
+        m_tree(),
+        m_index(storage),
+        m_stats(statsName)
     {
         ItemArray& array = builder.getUnsortedArray();
         TreeUtil::sortInPlace(array);
-        m_tree.constructFrom(array);
+        if (builder.getDuplicates().isChecked())
+            TreeUtil::removeDuplicates(array, builder.getDuplicates());
+        builder.getWeights().construct(m_tree, array);
+        m_index.build(m_tree);
     }
     ~RefMap() = default;
 
@@ -98,7 +133,32 @@ private:
 public:
     const TData* findKey(const TKey& key) const
     {
-        const TStructItem* item = static_cast<const TStructItem*>(TreeUtil::findInTree(m_tree, key));
+        const TStructItem* item = static_cast<const TStructItem*>(StatsUtil::find(m_index, m_tree, m_stats, key));
+        return item ? &(item->data()) : nullptr;
+    }
+
+    // finds a key of another type that TKeySort can compare with the keys,
+    // like a StrRef in a map of C strings ordered by StrLess
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    const TData* findKey(const TOther& key) const
+    {
+        const TStructItem* item = static_cast<const TStructItem*>(StatsUtil::find(m_index, m_tree, m_stats, key));
+        return item ? &(item->data()) : nullptr;
+    }
+
+    // finds many keys at once, see TreeFuncs::findKeys
+    void findKeys(const TKey* keys, size_t count, const TData** items) const
+    {
+        TreeUtil::findKeys(m_index, m_tree, keys, count, items);
+        StatsUtil::recordMany(m_tree, m_stats, keys, count, items);
+    }
+
+    // the counts of the lookups, if TStats keeps them
+    const TStats& getStats() const { return m_stats; }
+    // the item that findKey gives for a key that is not found, if any
+    const TData* getDefault() const
+    {
+        const TStructItem* item = static_cast<const TStructItem*>(m_tree.getDefault());
         return item ? &(item->data()) : nullptr;
     }
 
@@ -110,8 +170,20 @@ public:
         return seq;
     }
 
+public:
+    // these find items by their place in the order of the keys in O(log n)
+    // time, and work the same as the functions of the same name in TSequence
+    TIterator lowerBound(const TKey& key) const { return sequence().lower_bound(key); }
+    TIterator upperBound(const TKey& key) const { return sequence().upper_bound(key); }
+    std::pair<TIterator, TIterator> equalRange(const TKey& key) const { return sequence().equal_range(key); }
+    TSequence range(const TKey& lo, const TKey& hi) const { return sequence().range(lo, hi); }
+    // all of the items with the key, for a map that keeps repeated keys
+    TSequence findAll(const TKey& key) const { return sequence().range(key); }
+
 private:
     ItemTree m_tree;
+    TIndex m_index;
+    TStats m_stats;
 };
 } // namespace static_map
 #endif /* refmap_hpp */
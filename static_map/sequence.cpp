@@ -12,29 +12,6 @@
 
 namespace static_map
 {
-bool IterImpl::match(const IterImpl& rhs) const
-{
-    return (m_tree == rhs.m_tree) && (m_item == rhs.m_item);
-}
-
-void IterImpl::fwd()
-{
-    assert(m_tree);
-    if (m_item)
-        m_item = m_tree->getNext(m_item);
-    else
-        m_item = m_tree->getFirst();
-}
-
-void IterImpl::rev()
-{
-    assert(m_tree);
-    if (m_item)
-        m_item = m_tree->getPrev(m_item);
-    else
-        m_item = m_tree->getLast();
-}
-
 void IterImpl::makeFront(const ItemTree& tree)
 {
     m_tree = &tree;
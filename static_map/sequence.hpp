@@ -11,6 +11,7 @@
 
 #include <cassert>
 #include <iterator>
+#include <utility>
 
 #include "itemtree.hpp"
 
@@ -30,10 +31,20 @@ public:
     IterImpl& operator=(const IterImpl& rhs) = default;
 
 public:
-    bool match(const IterImpl& rhs) const;
+    bool match(const IterImpl& rhs) const { return (m_tree == rhs.m_tree) && (m_item == rhs.m_item); }
     const StructItem* get() const { return m_item; }
-    void fwd();
-    void rev();
+    // step to the next or prev item in O(1) time, these are inline since
+    // a full scan is little more than following the links
+    void fwd()
+    {
+        assert(m_tree);
+        m_item = m_item ? m_tree->getNext(m_item) : m_tree->getFirst();
+    }
+    void rev()
+    {
+        assert(m_tree);
+        m_item = m_item ? m_tree->getPrev(m_item) : m_tree->getLast();
+    }
 
 public:
     void makeFront(const ItemTree& tree);
@@ -125,13 +136,28 @@ public:
     typedef IteratorBase<TData> TIteratorBase;
 
 public:
-    Sequence() : m_tree(nullptr) {}
+    Sequence() : m_tree(nullptr), m_lo(nullptr), m_hi(nullptr) {}
     ~Sequence() = default;
     Sequence(const Sequence& rhs) = default;
     Sequence& operator=(const Sequence& rhs) = default;
 
 public:
-    void makeSequence(const ItemTree& tree) { m_tree = &tree; }
+    // makes it go over the whole tree
+    void makeSequence(const ItemTree& tree)
+    {
+        m_tree = &tree;
+        m_lo = tree.getFirst();
+        m_hi = nullptr;
+    }
+    // makes it go over the items of the tree from lo up to but not
+    // including hi, where nullptr is past the last item.  lo and hi must be
+    // the first items with their keys
+    void makeSequence(const ItemTree& tree, const StructItem* lo, const StructItem* hi)
+    {
+        m_tree = &tree;
+        m_lo = lo;
+        m_hi = hi;
+    }
 
 public:
     class const_iterator : public TIteratorBase
@@ -189,35 +215,30 @@ public:
     };
 
 public:
-    const_iterator find(const TKey& key)
+    const_iterator find(const TKey& key) { return findAny(key); }
+    // finds a key of another type that TKeySort can compare with the keys
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    const_iterator find(const TOther& key)
     {
-        assert(m_tree);
-        const StructItem* item = TreeUtil::findInTree(*m_tree, key);
-        const_iterator it;
-        it.makeIter(*m_tree, item);
-        return it;
+        return findAny(key);
     }
     const_iterator begin() const
     {
         assert(m_tree);
-        const_iterator it;
-        it.makeFront(*m_tree);
-        return it;
+        return makeIterator(m_lo);
     }
     const_iterator cbegin() const { return begin(); }
     const_iterator end() const
     {
         assert(m_tree);
-        const_iterator it;
-        it.makeNull(*m_tree);
-        return it;
+        return makeIterator(m_hi);
     }
     const_iterator cend() const { return end(); }
     const_reverse_iterator rbegin() const
     {
         assert(m_tree);
         const_reverse_iterator it;
-        it.makeBack(*m_tree);
+        it.makeIter(*m_tree, m_hi ? m_tree->getPrev(m_hi) : m_tree->getLast());
         return it;
     }
     const_reverse_iterator crbegin() const { return rbegin(); }
@@ -225,13 +246,94 @@ public:
     {
         assert(m_tree);
         const_reverse_iterator it;
-        it.makeNull(*m_tree);
+        it.makeIter(*m_tree, m_lo ? m_tree->getPrev(m_lo) : m_tree->getLast());
         return it;
     }
     const_reverse_iterator crend() const { return rend(); }
 
+public:
+    // finds the first item whose key is not less than the key in O(log n)
+    // time, returns end() if there is none
+    const_iterator lower_bound(const TKey& key) const
+    {
+        assert(m_tree);
+        return makeIterator(clamp(TreeUtil::lowerBoundInTree(*m_tree, key)));
+    }
+    // finds the first item whose key is greater than the key in O(log n)
+    // time, returns end() if there is none
+    const_iterator upper_bound(const TKey& key) const
+    {
+        assert(m_tree);
+        return makeIterator(clamp(TreeUtil::upperBoundInTree(*m_tree, key)));
+    }
+    // finds the items whose keys match the key in O(log n) time
+    std::pair<const_iterator, const_iterator> equal_range(const TKey& key) const
+    {
+        return std::make_pair(lower_bound(key), upper_bound(key));
+    }
+    // makes a Sequence of the items with keys from lo up to but not
+    // including hi in O(log n) time, which is empty if hi is not after lo
+    ThisType range(const TKey& lo, const TKey& hi) const
+    {
+        assert(m_tree);
+        ThisType seq(*this);
+        seq.m_lo = clamp(TreeUtil::lowerBoundInTree(*m_tree, lo));
+        seq.m_hi = clamp(TreeUtil::lowerBoundInTree(*m_tree, hi));
+        TKeySort compare;
+        if (!compare(lo, hi))
+            seq.m_lo = seq.m_hi;
+        return seq;
+    }
+    // makes a Sequence of the items whose keys match the key in O(log n)
+    // time, which go in the order they were added to the Builder
+    ThisType range(const TKey& key) const
+    {
+        assert(m_tree);
+        ThisType seq(*this);
+        seq.m_lo = clamp(TreeUtil::lowerBoundInTree(*m_tree, key));
+        seq.m_hi = clamp(TreeUtil::upperBoundInTree(*m_tree, key));
+        return seq;
+    }
+
+private:
+    template<typename TSearch>
+    const_iterator findAny(const TSearch& key) const
+    {
+        assert(m_tree);
+        const StructItem* item = TreeUtil::findInTree(*m_tree, key);
+        // a sub-range does not find what is outside of it
+        if (!item || clamp(item) != item)
+            item = m_hi;
+        return makeIterator(item);
+    }
+
+    const_iterator makeIterator(const StructItem* item) const
+    {
+        const_iterator it;
+        it.makeIter(*m_tree, item);
+        return it;
+    }
+
+    // moves an item of the tree into [m_lo, m_hi], where nullptr is past the
+    // last item.  the ends of a sequence are always the first of the items
+    // with their key, so comparing keys is enough to tell where an item is
+    const StructItem* clamp(const StructItem* item) const
+    {
+        if (!item || !m_lo)
+            return m_hi;
+        TKeySort compare;
+        if (compare(TreeUtil::keyOf(item), TreeUtil::keyOf(m_lo)))
+            return m_lo;
+        if (m_hi && !compare(TreeUtil::keyOf(item), TreeUtil::keyOf(m_hi)))
+            return m_hi;
+        return item;
+    }
+
 private:
     const ItemTree* m_tree;
+    // the first item and the item after the last, nullptr for past the end
+    const StructItem* m_lo;
+    const StructItem* m_hi;
 };
 } // namespace static_map
 
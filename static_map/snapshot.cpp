@@ -0,0 +1,207 @@
+//
+//  snapshot.cpp
+//  StaticMap
+//
+
+#include "snapshot.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace static_map
+{
+
+static const char s_magic[8] = {'S', 'M', 'A', 'P', 'S', 'N', 'A', 'P'};
+static const uint32_t s_version = 2;
+static const uint32_t s_byteOrder = 0x01020304;
+// every section starts on a multiple of this
+static const size_t s_alignment = 8;
+
+static size_t alignUp(size_t pos)
+{
+    return (pos + s_alignment - 1) / s_alignment * s_alignment;
+}
+
+void SnapshotValue<const char*>::put(SnapshotWriter& writer, size_t pos, const char* value)
+{
+    assert(value);
+    const int64_t offset = static_cast<int64_t>(writer.putString(value)) - static_cast<int64_t>(pos);
+    writer.putBytes(pos, &offset, sizeof(offset));
+}
+
+//
+//
+//
+
+bool SnapshotFile::open(const char* path, size_t recordSize, size_t sectionCount)
+{
+    assert(!m_data);
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays after the file is closed
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const char*>(data);
+    m_size = size;
+    if (!isValid(recordSize, sectionCount))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SnapshotFile::close()
+{
+    if (m_data)
+    {
+        ::munmap(const_cast<char*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+const void* SnapshotFile::getRecords(size_t section) const
+{
+    assert(section < SnapshotHeader::s_maxSections);
+    return m_data ? m_data + header()->m_sections[section].m_offset : nullptr;
+}
+
+size_t SnapshotFile::getCount(size_t section) const
+{
+    assert(section < SnapshotHeader::s_maxSections);
+    return m_data ? static_cast<size_t>(header()->m_sections[section].m_count) : 0;
+}
+
+const void* SnapshotFile::getDefault(size_t section) const
+{
+    assert(section < SnapshotHeader::s_maxSections);
+    if (!m_data)
+        return nullptr;
+    const SnapshotHeader& h = *header();
+    const SnapshotSection& s = h.m_sections[section];
+    if (s.m_default == SnapshotSection::s_noDefault)
+        return nullptr;
+    return m_data + s.m_offset + s.m_default * h.m_recordSize;
+}
+
+// only the header is read, and the sections are checked to be in the file.
+// the records themselves are trusted.
+bool SnapshotFile::isValid(size_t recordSize, size_t sectionCount) const
+{
+    const SnapshotHeader& h = *header();
+    if (memcmp(h.m_magic, s_magic, sizeof(s_magic)) != 0 || h.m_version != s_version ||
+        h.m_byteOrder != s_byteOrder || h.m_wordSize != sizeof(size_t) || h.m_recordSize != recordSize ||
+        h.m_sectionCount != sectionCount || h.m_fileSize != m_size)
+        return false;
+    for (size_t i = 0; i < sectionCount; ++i)
+    {
+        const SnapshotSection& section = h.m_sections[i];
+        if (section.m_offset % s_alignment != 0 || section.m_offset < sizeof(SnapshotHeader) ||
+            section.m_offset > m_size)
+            return false;
+        if (section.m_count > (m_size - section.m_offset) / recordSize)
+            return false;
+        if (section.m_default != SnapshotSection::s_noDefault && section.m_default >= section.m_count)
+            return false;
+    }
+    return true;
+}
+
+//
+//
+//
+
+SnapshotWriter::SnapshotWriter(size_t recordSize) : m_records(alignUp(sizeof(SnapshotHeader))), m_blob(), m_strings()
+{
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, s_magic, sizeof(s_magic));
+    header.m_version = s_version;
+    header.m_byteOrder = s_byteOrder;
+    header.m_wordSize = sizeof(size_t);
+    header.m_recordSize = static_cast<uint32_t>(recordSize);
+    memcpy(m_records.data(), &header, sizeof(header));
+}
+
+size_t SnapshotWriter::addSection(size_t count)
+{
+    assert(m_blob.empty());
+    SnapshotHeader* header = reinterpret_cast<SnapshotHeader*>(m_records.data());
+    assert(header->m_sectionCount < SnapshotHeader::s_maxSections);
+    const size_t pos = alignUp(m_records.size());
+    SnapshotSection& section = header->m_sections[header->m_sectionCount++];
+    section.m_offset = pos;
+    section.m_count = count;
+    section.m_default = SnapshotSection::s_noDefault;
+    // the header may move when this grows
+    m_records.resize(alignUp(pos + count * header->m_recordSize));
+    return pos;
+}
+
+void SnapshotWriter::setDefault(size_t section, size_t index)
+{
+    SnapshotHeader* header = reinterpret_cast<SnapshotHeader*>(m_records.data());
+    assert(section < header->m_sectionCount);
+    assert(index < header->m_sections[section].m_count);
+    header->m_sections[section].m_default = index;
+}
+
+void SnapshotWriter::putBytes(size_t pos, const void* bytes, size_t size)
+{
+    assert(pos + size <= m_records.size());
+    memcpy(m_records.data() + pos, bytes, size);
+}
+
+size_t SnapshotWriter::putString(const char* value)
+{
+    std::map<std::string, size_t>::const_iterator it = m_strings.find(value);
+    if (it == m_strings.end())
+    {
+        const size_t length = strlen(value) + 1;
+        it = m_strings.insert(std::make_pair(std::string(value), m_blob.size())).first;
+        m_blob.insert(m_blob.end(), value, value + length);
+    }
+    // the blob goes right after the sections
+    return m_records.size() + it->second;
+}
+
+bool SnapshotWriter::writeTo(const char* path)
+{
+    SnapshotHeader* header = reinterpret_cast<SnapshotHeader*>(m_records.data());
+    header->m_fileSize = m_records.size() + m_blob.size();
+
+    // write a file next to it, then put it in place
+    const std::string temp = std::string(path) + ".tmp";
+    FILE* file = fopen(temp.c_str(), "wb");
+    if (!file)
+        return false;
+    bool written = fwrite(m_records.data(), 1, m_records.size(), file) == m_records.size();
+    written = written && (m_blob.empty() || fwrite(m_blob.data(), 1, m_blob.size(), file) == m_blob.size());
+    written = (fclose(file) == 0) && written;
+    if (!written || rename(temp.c_str(), path) != 0)
+    {
+        remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace static_map
@@ -0,0 +1,197 @@
+//
+//  snapshot.hpp
+//  StaticMap
+//
+
+#ifndef snapshot_hpp
+#define snapshot_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace static_map
+{
+
+class SnapshotWriter;
+
+//
+// A snapshot is a map written out to a file in a form that can be used
+// straight from a read only mapping of the file.  It is laid out as:
+//
+//   SnapshotHeader
+//   section 0 -- the records sorted by the (first) key
+//   section 1 -- for a BiMap, the records sorted by the second key
+//   blob      -- the characters of the strings, each one once
+//
+// Each record is a fixed size struct made of SnapshotValue fields.  Strings
+// are stored as the distance from their field to their characters, so the
+// file does not depend on where it is mapped.  Numbers are stored as they
+// are in memory, so a snapshot can only be read on a machine with the same
+// byte order and type sizes as the one that wrote it, which the header is
+// checked for.  The header also gives the place of the default record of
+// each section, if the map has a default item.
+//
+
+//
+// SnapshotValue: how a value is stored in a record.  get gives back the
+// value from the mapping, and put writes the value into the snapshot at the
+// position given.  Integers, floating point numbers and enums are stored as
+// they are, and C strings go in the blob.  Other types cannot be stored.
+//
+template<typename T, typename TEnable = void>
+struct SnapshotValue;
+
+template<typename T>
+struct SnapshotValue<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type>
+{
+    T m_value;
+
+    T get() const { return m_value; }
+    static void put(SnapshotWriter& writer, size_t pos, const T& value);
+};
+
+template<>
+struct SnapshotValue<const char*>
+{
+    int64_t m_offset;
+
+    const char* get() const { return reinterpret_cast<const char*>(this) + m_offset; }
+    static void put(SnapshotWriter& writer, size_t pos, const char* value);
+};
+
+//
+// SnapshotSection: where a section of records is in the file
+//
+struct SnapshotSection
+{
+    static const uint64_t s_noDefault = ~static_cast<uint64_t>(0);
+
+    uint64_t m_offset;
+    uint64_t m_count;
+    // the place of the default record in the section, or s_noDefault
+    uint64_t m_default;
+};
+
+//
+// SnapshotHeader: the start of every snapshot
+//
+struct SnapshotHeader
+{
+    static const size_t s_maxSections = 2;
+
+    char m_magic[8];
+    uint32_t m_version;
+    // s_byteOrder as it was written, to check the byte order
+    uint32_t m_byteOrder;
+    // the size of size_t, to check the type sizes
+    uint32_t m_wordSize;
+    uint32_t m_recordSize;
+    uint32_t m_sectionCount;
+    uint32_t m_reserved;
+    uint64_t m_fileSize;
+    SnapshotSection m_sections[s_maxSections];
+};
+
+//
+// SnapshotFile: a read only mapping of a whole snapshot file.  Nothing is
+// read or copied when it is opened except to check the header, so it costs
+// only the mmap, and processes that map the same file share its pages.
+//
+class SnapshotFile
+{
+public:
+    SnapshotFile() : m_data(nullptr), m_size(0) {}
+    ~SnapshotFile() { close(); }
+
+private:
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+public:
+    // maps the file and checks that it is a snapshot that this machine can
+    // read with records of the size given and the number of sections given,
+    // returns false if it cannot
+    bool open(const char* path, size_t recordSize, size_t sectionCount);
+    // unmaps the file
+    void close();
+    // returns true if the file is mapped
+    bool isOpen() const { return m_data != nullptr; }
+
+public:
+    // gets the first record of a section, nullptr if not open
+    const void* getRecords(size_t section) const;
+    // gets the number of records in a section, 0 if not open
+    size_t getCount(size_t section) const;
+    // gets the default record of a section, nullptr if it has none or if
+    // not open
+    const void* getDefault(size_t section) const;
+
+private:
+    const SnapshotHeader* header() const { return reinterpret_cast<const SnapshotHeader*>(m_data); }
+    bool isValid(size_t recordSize, size_t sectionCount) const;
+
+private:
+    const char* m_data;
+    size_t m_size;
+};
+
+//
+// SnapshotWriter: lays out a snapshot in memory and writes it to a file.
+// All of the sections are added first, then the values of the records are
+// put in, then it is written.  This is for the tool that makes the
+// snapshot, so unlike the rest of the library, it allocates.
+//
+class SnapshotWriter
+{
+public:
+    explicit SnapshotWriter(size_t recordSize);
+    ~SnapshotWriter() = default;
+
+private:
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+public:
+    // adds a section of count records, returns the position of its first
+    // record.  cannot be called once values have been put in
+    size_t addSection(size_t count);
+    // makes the record at the index of the section its default
+    void setDefault(size_t section, size_t index);
+    // puts a value into the field at the position
+    template<typename T>
+    void put(size_t pos, const T& value)
+    {
+        SnapshotValue<T>::put(*this, pos, value);
+    }
+    // copies the bytes of a value into the field at the position
+    void putBytes(size_t pos, const void* bytes, size_t size);
+    // puts the characters of the string into the blob if they are not
+    // already there, returns their position in the file
+    size_t putString(const char* value);
+    // writes the snapshot to the file, replacing it all at once so that a
+    // process mapping the old file does not see it change
+    bool writeTo(const char* path);
+
+private:
+    // the header and the sections
+    std::vector<char> m_records;
+    // the strings
+    std::vector<char> m_blob;
+    // where each string is in the blob
+    std::map<std::string, size_t> m_strings;
+};
+
+template<typename T>
+void SnapshotValue<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type>::put(
+    SnapshotWriter& writer, size_t pos, const T& value)
+{
+    writer.putBytes(pos, &value, sizeof(value));
+}
+
+} // namespace static_map
+
+#endif /* snapshot_hpp */
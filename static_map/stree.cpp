@@ -0,0 +1,10 @@
+//
+//  stree.cpp
+//  StaticMap
+//
+
+#include "stree.hpp"
+
+namespace static_map
+{
+}
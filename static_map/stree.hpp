@@ -0,0 +1,331 @@
+//
+//  stree.hpp
+//  StaticMap
+//
+
+#ifndef stree_hpp
+#define stree_hpp
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "itemtree.hpp"
+
+namespace static_map
+{
+
+//
+// STreeKeys: says whether blocks of TKey can be searched with SIMD compares.
+// That is only the case when the keys are 32 bit ints (or enums the size of
+// an int) that are ordered the way that ints are.
+//
+template<typename TKey, typename TKeySort>
+struct STreeKeys
+{
+    static const bool isSimd = false;
+};
+
+template<typename TKey>
+struct STreeKeys<TKey, std::less<int>>
+{
+    static const bool isSimd =
+        std::is_same<TKey, int>::value || (std::is_enum<TKey>::value && sizeof(TKey) == sizeof(int));
+};
+
+//
+// STreeIndex: a lookup index for a map that copies the keys into a static
+// B-tree (an S-tree) held in an array of blocks given by the caller.  Each
+// block holds 16 sorted keys, which for ints is one cache line, and the
+// blocks are laid out in breadth first order with block k having its 17
+// children starting at block 17k+1.  Each level of the search is then one
+// cache line, and for int keys, the position within a block is found with
+// a SIMD compare and movemask (AVX2 or SSE2), with a scalar loop on other
+// targets.  The item pointers are kept beside the keys so that a found key
+// gives back the same item that the tree would.
+//
+// Use it by giving it to the map as its index and passing a big enough
+// static array of blocks to the map's constructor:
+//
+// typedef UniMap<int, const char*, std::less<int>, STreeIndex> M;
+// static M::TIndex::Block s_blocks[M::TIndex::blocksFor(1000)];
+// static M s_map(s_builder, s_blocks);
+//
+// If there are more items than the blocks can hold, the map will search
+// the tree instead.  TKey must be default constructible and copy assignable.
+//
+template<typename TData, typename TKey, typename TKeyGet, typename TKeySort>
+class STreeIndex
+{
+private:
+    typedef StructItemT<TData> TStructItem;
+    typedef TreeFuncs<TData, TKey, TKeyGet, TKeySort> TreeUtil;
+
+public:
+    // the number of keys in a block
+    static const size_t s_blockSize = 16;
+
+    // a block of keys and the items that they came from
+    struct alignas(64) Block
+    {
+        TKey m_keys[s_blockSize];
+        const StructItem* m_items[s_blockSize];
+    };
+
+    // the caller supplied array of blocks
+    class Storage
+    {
+    public:
+        Storage() : m_blocks(nullptr), m_capacity(0) {}
+        template<size_t N>
+        Storage(Block (&blocks)[N]) : m_blocks(blocks), m_capacity(N)
+        {
+        }
+        Storage(Block* blocks, size_t capacity) : m_blocks(blocks), m_capacity(capacity) {}
+
+    public:
+        Block* blocks() const { return m_blocks; }
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        Block* m_blocks;
+        size_t m_capacity;
+    };
+
+public:
+    STreeIndex() : m_storage(), m_blockCount(0) {}
+    explicit STreeIndex(const Storage& storage) : m_storage(storage), m_blockCount(0) {}
+    ~STreeIndex() = default;
+
+private:
+    STreeIndex(const STreeIndex&) = delete;
+    STreeIndex& operator=(const STreeIndex&) = delete;
+
+public:
+    // the number of blocks needed to hold count keys
+    static constexpr size_t blocksFor(size_t count) { return (count + s_blockSize - 1) / s_blockSize; }
+    // returns true if the blocks are being used for lookups
+    bool isBuilt() const { return m_blockCount != 0; }
+
+public:
+    // copies the keys from the tree in O(n) time if there is room
+    void build(const ItemTree& tree)
+    {
+        assert(!m_blockCount);
+        size_t count = tree.getCount();
+        size_t blockCount = blocksFor(count);
+        if (blockCount == 0 || blockCount > m_storage.capacity())
+            return;
+        m_blockCount = blockCount;
+        // the unused slots all come after the real keys, so they can be
+        // filled with copies of the largest key and no item
+        const StructItem* item = tree.getFirst();
+        const TKey& largest = keyOf(tree.getLast());
+        fillInOrder(tree, 0, item, largest);
+        assert(!item);
+    }
+
+    // finds the key in O(log n) time, returns the default item if not found
+    const StructItem* find(const ItemTree& tree, const TKey& key) const
+    {
+        if (!m_blockCount)
+            return TreeUtil::findInTree(tree, key);
+
+        // find the first key that is not less than the key, keeping the
+        // last one seen on the way down since the lower levels will only
+        // find something smaller
+        Search search = {0, nullptr, 0};
+        while (search.m_block < m_blockCount)
+            stepDown(search, key);
+        return itemFor(tree, search, key);
+    }
+
+    // finds a key of another type that TKeySort can compare with the keys
+    // by searching the tree, since the blocks can only be searched for a TKey
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    const StructItem* find(const ItemTree& tree, const TOther& key) const
+    {
+        return TreeUtil::findInTree(tree, key);
+    }
+
+    // does find for up to s_batchSize keys at once, with every search going
+    // down a level before any of them goes down the next one
+    void findMany(const ItemTree& tree, const TKey* keys, size_t count, const StructItem** items) const
+    {
+        if (!m_blockCount)
+        {
+            TreeUtil::findManyInTree(tree, keys, count, items);
+            return;
+        }
+
+        assert(count <= TreeUtil::s_batchSize);
+        Search searches[TreeUtil::s_batchSize];
+        for (size_t i = 0; i < count; ++i)
+        {
+            searches[i].m_block = 0;
+            searches[i].m_candidate = nullptr;
+        }
+        bool going = true;
+        while (going)
+        {
+            going = false;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (searches[i].m_block < m_blockCount)
+                {
+                    stepDown(searches[i], keys[i]);
+                    going = true;
+                }
+            }
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            items[i] = itemFor(tree, searches[i], keys[i]);
+        }
+    }
+
+private:
+    // where a search is, and the block and slot of the first key not less
+    // than the key that it has seen so far
+    struct Search
+    {
+        size_t m_block;
+        const Block* m_candidate;
+        size_t m_slot;
+    };
+
+    // searches the block that the search is at, and moves it to the child
+    // that the key belongs in
+    void stepDown(Search& search, const TKey& key) const
+    {
+        const Block& block = m_storage.blocks()[search.m_block];
+        const size_t i = rankInBlock(block, key);
+        if (i < s_blockSize)
+        {
+            search.m_candidate = &block;
+            search.m_slot = i;
+        }
+        search.m_block = childOf(search.m_block, i);
+        if (search.m_block < m_blockCount)
+            STATIC_MAP_PREFETCH(m_storage.blocks() + search.m_block);
+    }
+
+    // the item that a finished search found
+    static const StructItem* itemFor(const ItemTree& tree, const Search& search, const TKey& key)
+    {
+        if (search.m_candidate)
+        {
+            const StructItem* item = search.m_candidate->m_items[search.m_slot];
+            TKeySort compare;
+            if (item && !compare(key, search.m_candidate->m_keys[search.m_slot]))
+                return item;
+        }
+        return tree.getDefault();
+    }
+
+    // the i-th child of block k
+    static size_t childOf(size_t k, size_t i) { return k * (s_blockSize + 1) + i + 1; }
+
+    static const TKey& keyOf(const StructItem* item)
+    {
+        return TKeyGet::key(static_cast<const TStructItem*>(item)->data());
+    }
+
+    // walk the implied B-tree in order, putting the next item of the tree
+    // into each slot as it is reached
+    void fillInOrder(const ItemTree& tree, size_t k, const StructItem*& item, const TKey& largest)
+    {
+        if (k >= m_blockCount)
+            return;
+        Block& block = m_storage.blocks()[k];
+        for (size_t i = 0; i < s_blockSize; ++i)
+        {
+            fillInOrder(tree, childOf(k, i), item, largest);
+            if (item)
+            {
+                block.m_keys[i] = keyOf(item);
+                block.m_items[i] = item;
+                item = tree.getNext(item);
+            }
+            else
+            {
+                block.m_keys[i] = largest;
+                block.m_items[i] = nullptr;
+            }
+        }
+        fillInOrder(tree, childOf(k, s_blockSize), item, largest);
+    }
+
+    // the number of keys in the block that are less than the key, which
+    // is where the key would go since the block is sorted
+    static size_t rankInBlock(const Block& block, const TKey& key)
+    {
+        return rankInBlock(block, key, std::integral_constant<bool, STreeKeys<TKey, TKeySort>::isSimd>());
+    }
+
+    // the scalar version, counted without branching
+    static size_t rankInBlock(const Block& block, const TKey& key, std::false_type)
+    {
+        TKeySort compare;
+        size_t rank = 0;
+        for (size_t i = 0; i < s_blockSize; ++i)
+            rank += compare(block.m_keys[i], key) ? 1 : 0;
+        return rank;
+    }
+
+    // the SIMD version for int sized keys
+    static size_t rankInBlock(const Block& block, const TKey& key, std::true_type)
+    {
+        const int* keys = reinterpret_cast<const int*>(block.m_keys);
+        const int value = static_cast<int>(key);
+#if defined(__AVX2__)
+        const __m256i x = _mm256_set1_epi32(value);
+        const __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i*>(keys));
+        const __m256i hi = _mm256_load_si256(reinterpret_cast<const __m256i*>(keys + 8));
+        // each key that is less than the value sets a bit
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, lo))));
+        mask |= static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, hi)))) << 8;
+        return countBits(mask);
+#elif defined(__SSE2__)
+        const __m128i x = _mm_set1_epi32(value);
+        unsigned mask = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const __m128i part = _mm_load_si128(reinterpret_cast<const __m128i*>(keys + 4 * i));
+            // each key that is less than the value sets a bit
+            mask |= static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, part)))) << (4 * i);
+        }
+        return countBits(mask);
+#else
+        size_t rank = 0;
+        for (size_t i = 0; i < s_blockSize; ++i)
+            rank += (keys[i] < value) ? 1 : 0;
+        return rank;
+#endif
+    }
+
+    static size_t countBits(unsigned mask)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_popcount(mask));
+#else
+        size_t count = 0;
+        for (; mask; mask &= mask - 1)
+            ++count;
+        return count;
+#endif
+    }
+
+private:
+    Storage m_storage;
+    size_t m_blockCount;
+};
+
+} // namespace static_map
+
+#endif /* stree_hpp */
@@ -0,0 +1,10 @@
+//
+//  strref.cpp
+//  StaticMap
+//
+
+#include "strref.hpp"
+
+namespace static_map
+{
+}
@@ -0,0 +1,126 @@
+//
+//  strref.hpp
+//  StaticMap
+//
+
+#ifndef strref_hpp
+#define strref_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "itemtree.hpp"
+
+namespace static_map
+{
+
+//
+// StrRef: the characters of a string given by a pointer and a length, which
+// do not have to end in a NUL.  It is for looking up a C string key with
+// text that is part of something bigger, like a field name in a packet,
+// without copying it out first.  It only points at the characters, which
+// must outlive it.
+//
+class StrRef
+{
+public:
+    constexpr StrRef() : m_data(""), m_size(0) {}
+    constexpr StrRef(const char* data, size_t size) : m_data(data), m_size(size) {}
+    StrRef(const char* str) : m_data(str), m_size(strlen(str)) {}
+    StrRef(const std::string& str) : m_data(str.data()), m_size(str.size()) {}
+
+public:
+    constexpr const char* data() const { return m_data; }
+    constexpr size_t size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t m_size;
+};
+
+//
+// StrLess: orders C strings like strcmp, and is transparent, so that a map
+// with C string keys ordered by it can be searched with a StrRef (or a
+// std::string, which converts to one) as well as a C string.  A StrRef with
+// a NUL in it is after the C string that ends there.
+//
+struct StrLess
+{
+    typedef void is_transparent;
+
+    bool operator()(const char* s1, const char* s2) const { return strcmp(s1, s2) < 0; }
+    bool operator()(const char* s1, const StrRef& s2) const { return compare(s1, s2) < 0; }
+    bool operator()(const StrRef& s1, const char* s2) const { return compare(s2, s1) > 0; }
+    bool operator()(const StrRef& s1, const StrRef& s2) const
+    {
+        const size_t size = (s1.size() < s2.size()) ? s1.size() : s2.size();
+        const int result = memcmp(s1.data(), s2.data(), size);
+        return (result != 0) ? (result < 0) : (s1.size() < s2.size());
+    }
+
+private:
+    // like strcmp of s1 and s2
+    static int compare(const char* s1, const StrRef& s2)
+    {
+        const unsigned char* c1 = reinterpret_cast<const unsigned char*>(s1);
+        const unsigned char* c2 = reinterpret_cast<const unsigned char*>(s2.data());
+        for (size_t i = 0; i < s2.size(); ++i)
+        {
+            // s1 ended first, even if s2 has a NUL here
+            if (c1[i] == 0)
+                return -1;
+            if (c1[i] != c2[i])
+                return (c1[i] < c2[i]) ? -1 : 1;
+        }
+        return (c1[s2.size()] != 0) ? 1 : 0;
+    }
+};
+
+//
+// the prefix of a C string ordered by StrLess is the 8 characters after the
+// start that all of the names share (like ORDER_STATUS_), as a big endian
+// number so that the prefixes are in the same order as the strings, with
+// zeros after the end of a shorter string.  most names are told apart by it
+// without going to their characters, and a name with less than 8 characters
+// after the shared start is all in it.  names that have the same prefix are
+// compared with strcmp.
+//
+template<>
+struct KeyCache<const char*, StrLess>
+{
+    static const bool isCached = true;
+    static const bool isExact = false;
+    static uint64_t prefixOf(const char* key, size_t skip)
+    {
+        key += skip;
+        uint64_t prefix = 0;
+        bool ended = false;
+        for (size_t i = 0; i < sizeof(prefix); ++i)
+        {
+            // nothing past the end of the string is read
+            const unsigned char c = ended ? 0 : static_cast<unsigned char>(key[i]);
+            ended = (c == 0);
+            prefix = (prefix << 8) | c;
+        }
+        return prefix;
+    }
+    // the number of characters at the start of both strings that are the
+    // same, up to most
+    static size_t sharedLength(const char* key1, const char* key2, size_t most)
+    {
+        size_t i = 0;
+        while (i < most && key1[i] != 0 && key1[i] == key2[i])
+        {
+            ++i;
+        }
+        return i;
+    }
+    // the string ended in the prefix if the last byte is a zero
+    static bool isWhole(uint64_t prefix) { return (prefix & 0xff) == 0; }
+};
+
+} // namespace static_map
+
+#endif /* strref_hpp */
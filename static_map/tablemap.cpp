@@ -0,0 +1,10 @@
+//
+//  tablemap.cpp
+//  StaticMap
+//
+
+#include "tablemap.hpp"
+
+namespace static_map
+{
+}
@@ -0,0 +1,162 @@
+//
+//  tablemap.hpp
+//  StaticMap
+//
+
+#ifndef tablemap_hpp
+#define tablemap_hpp
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+
+namespace static_map
+{
+
+//
+// TableMap: a map over an array of items that is already sorted, for tables
+// that are too big to write out as Items registering with a Builder.  The
+// array is meant to be written by the smgen tool (tools/smgen.cpp) from a
+// table at build time, which sorts the rows and checks the keys, so that
+// nothing is sorted or linked when the process starts:
+//
+// typedef TableMap<int, const char*> M;
+// static constexpr M::Item s_items[] = {{1, "ONE"}, {2, "TWO"}, {3, "THREE"}};
+// static constexpr M s_map(s_items);
+//
+// When the items and the map are constexpr, they are constants in read only
+// memory, and the map is not subject to the order of static initialization.
+// The items must be sorted by TKeySort, which is asserted in debug builds,
+// and findKey finds the first of a repeated key.  smgen also checks that no
+// key is repeated.  ConstMap keeps its items in the same Item array and is
+// looked up through a TableMap, so both have the same findKey and sequence,
+// and a key that is not found gives nullptr.
+//
+template<typename TKey, typename TVal, typename TKeySort = std::less<TKey>>
+class TableMap
+{
+public:
+    class Item;
+    class Sequence;
+    typedef TableMap<TKey, TVal, TKeySort> ThisType;
+    typedef Item TData;
+    typedef Sequence TSequence;
+
+public:
+    //
+    // Item is a row of the table, holding the TKey and TVal instances
+    //
+    class Item
+    {
+    public:
+        constexpr Item(const TKey& key, const TVal& val) : m_key(key), m_val(val) {}
+
+    public:
+        constexpr const TKey& key() const { return m_key; }
+        constexpr const TVal& val() const { return m_val; }
+
+    private:
+        TKey m_key;
+        TVal m_val;
+    };
+
+public:
+    //
+    // Sequence goes over the items in order.  The items are in an array, so
+    // the iterators are pointers, and the Sequence holds the array rather
+    // than the map, so it can outlive a TableMap made for a lookup.
+    //
+    class Sequence
+    {
+    public:
+        typedef const Item* const_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    public:
+        constexpr Sequence(const Item* items, size_t count) : m_items(items), m_count(count) {}
+
+    public:
+        constexpr const_iterator find(const TKey& key) const
+        {
+            const Item* item = findIn(m_items, m_count, key);
+            return item ? item : end();
+        }
+        constexpr const_iterator begin() const { return m_items; }
+        constexpr const_iterator cbegin() const { return begin(); }
+        constexpr const_iterator end() const { return m_items + m_count; }
+        constexpr const_iterator cend() const { return end(); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator crbegin() const { return rbegin(); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+        const_reverse_iterator crend() const { return rend(); }
+
+    private:
+        const Item* m_items;
+        size_t m_count;
+    };
+
+public:
+    template<size_t N>
+    constexpr explicit TableMap(const Item (&items)[N]) : TableMap(items, N)
+    {
+    }
+    constexpr TableMap(const Item* items, size_t count) : m_items(items), m_count(count)
+    {
+        assert(isSorted(items, count));
+    }
+
+public:
+    // finds the key in O(log n) time, returns nullptr if not found
+    constexpr const TData* findKey(const TKey& key) const { return findIn(m_items, m_count, key); }
+
+public:
+    constexpr TSequence sequence() const { return TSequence(m_items, m_count); }
+    constexpr size_t size() const { return m_count; }
+
+public:
+    // finds the first item with the key in the sorted array of items in
+    // O(log n) time, returns nullptr if not found
+    static constexpr const Item* findIn(const Item* items, size_t size, const TKey& key)
+    {
+        TKeySort compare{};
+        const Item* first = items;
+        size_t count = size;
+        while (count > 0)
+        {
+            const size_t step = count / 2;
+            const Item* middle = first + step;
+            if (compare(middle->key(), key))
+            {
+                first = middle + 1;
+                count -= step + 1;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+        const bool found = (first != items + size) && !compare(key, first->key());
+        return found ? first : nullptr;
+    }
+
+    // returns true if no item is less than the one before it
+    static constexpr bool isSorted(const Item* items, size_t count)
+    {
+        TKeySort compare{};
+        for (size_t i = 1; i < count; ++i)
+        {
+            if (compare(items[i].key(), items[i - 1].key()))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    const Item* m_items;
+    size_t m_count;
+};
+
+} // namespace static_map
+
+#endif /* tablemap_hpp */
@@ -10,8 +10,14 @@
 #define unimap_hpp
 
 #include "builderbase.hpp"
+#include "denseindex.hpp"
+#include "eytzinger.hpp"
 #include "itemtree.hpp"
+#include "mapstats.hpp"
+#include "perfecthash.hpp"
+#include "ranked.hpp"
 #include "sequence.hpp"
+#include "stree.hpp"
 
 namespace static_map
 {
@@ -60,6 +66,10 @@ namespace static_map
 //
 // then we would really be cooking with fire.
 //
+// for tables with many rows, the smgen tool (tools/smgen.cpp) writes a
+// TableMap (tablemap.hpp) from a CSV file instead.  its items are sorted
+// when the tool runs, so the map has nothing to do at startup.
+//
 
 //
 // UniMap: the no alloc map is constructed by giving it a fully filled Builder
@@ -86,16 +96,39 @@ namespace static_map
 // Use the find function to find the item with the matching key.  this
 // function will return nullptr to indicate failure
 //
+// lowerBound, upperBound and equalRange find items by where their keys fall
+// in the order, and range gives a Sequence of only the items with keys from
+// lo up to but not including hi.  all of these are O(log n).
+//
+// A map is a multimap when its Builder is given
+// TDuplicates::keepInOrder().  the items with the same key are then kept
+// in the order they were added, findKey finds the first of them, and
+// findAll gives a Sequence of all of them in O(log n) time.
+//
+// To find items by their place in the order, like the nth item or the rank
+// of a key, copy a Sequence into a TRanked (see ranked.hpp).
+//
+// By default the find function searches the tree.  A different lookup
+// index, like EytzingerIndex, STreeIndex, PerfectHashIndex or DenseIndex,
+// can be given as TLookup along with the storage that it needs when the map
+// is constructed.
+//
+// To count the lookups of a map, give LookupStats as TStats and a name for
+// the map when it is constructed (see mapstats.hpp).
+//
 
-template<typename TKey, typename TVal, typename TKeySort = std::less<TKey>>
+template<typename TKey, typename TVal, typename TKeySort = std::less<TKey>,
+         template<typename, typename, typename, typename> class TLookup = TreeIndex, typename TStats = NoStats>
 class UniMap
 {
 public:
     class Item;
     class Builder;
-    typedef UniMap<TKey, TVal, TKeySort> ThisType;
+    typedef UniMap<TKey, TVal, TKeySort, TLookup, TStats> ThisType;
     typedef Builder TBuilder;
     typedef Item TData;
+    typedef DuplicatePolicy<TData> TDuplicates;
+    typedef WeightPolicy<TData> TWeights;
 
 private:
     class GetKey;
@@ -105,6 +138,13 @@ private:
 
 public:
     typedef Sequence<TData, TKey, TKeyGet, TKeySort> TSequence;
+    typedef typename TSequence::const_iterator TIterator;
+    typedef RankedSequence<TData, TKey, TKeyGet, TKeySort> TRanked;
+    typedef TLookup<TData, TKey, TKeyGet, TKeySort> TIndex;
+    typedef typename TIndex::Storage TIndexStorage;
+
+private:
+    typedef StatsFuncs<TreeUtil, TIndex, TStats> StatsUtil;
 
 public:
     //
@@ -116,8 +156,9 @@ public:
     // contents, so do not pass the builder into a second map class and expect
     // any results.
     //
-    // This class does nothing, but it exists for type safety to make sure that
-    // Builder matches the Item and the UniMap.
+    // Other than holding the DuplicatePolicy and the WeightPolicy, this class
+    // does nothing, but it exists for type safety to make sure that Builder
+    // matches the Item and the UniMap.
     //
     class Builder : public BuilderBase
     {
@@ -125,8 +166,23 @@ public:
         typedef BuilderBase Base;
 
     public:
-        Builder() = default;
+        constexpr Builder() : Base(), m_duplicates(), m_weights() {}
+        constexpr explicit Builder(const TDuplicates& duplicates, const TWeights& weights = TWeights()) :
+            Base(),
+            m_duplicates(duplicates),
+            m_weights(weights)
+        {
+        }
+        constexpr explicit Builder(const TWeights& weights) : Base(), m_duplicates(), m_weights(weights) {}
         ~Builder() = default;
+
+    public:
+        const TDuplicates& getDuplicates() const { return m_duplicates; }
+        const TWeights& getWeights() const { return m_weights; }
+
+    private:
+        TDuplicates m_duplicates;
+        TWeights m_weights;
     };
 
 public:
@@ -178,11 +234,17 @@ private:
     };
 
 public:
-    UniMap(TBuilder& builder) : m_tree()
+    UniMap(TBuilder& builder, const TIndexStorage& storage = TIndexStorage(), const char* statsName = nullptr) :
+        m_tree(),
+        m_index(storage),
+        m_stats(statsName)
     {
         ItemArray& array = builder.getUnsortedArray();
         TreeUtil::sortInPlace(array);
-        m_tree.constructFrom(array);
+        if (builder.getDuplicates().isChecked())
+            TreeUtil::removeDuplicates(array, builder.getDuplicates());
+        builder.getWeights().construct(m_tree, array);
+        m_index.build(m_tree);
     }
     ~UniMap() = default;
 
@@ -193,7 +255,32 @@ private:
 public:
     const TData* findKey(const TKey& key) const
     {
-        const TStructItem* item = static_cast<const TStructItem*>(TreeUtil::findInTree(m_tree, key));
+        const TStructItem* item = static_cast<const TStructItem*>(StatsUtil::find(m_index, m_tree, m_stats, key));
+        return item ? &(item->data()) : nullptr;
+    }
+
+    // finds a key of another type that TKeySort can compare with the keys,
+    // like a StrRef in a map of C strings ordered by StrLess
+    template<typename TOther, typename = EnableIfTransparent<TKeySort, TOther>>
+    const TData* findKey(const TOther& key) const
+    {
+        const TStructItem* item = static_cast<const TStructItem*>(StatsUtil::find(m_index, m_tree, m_stats, key));
+        return item ? &(item->data()) : nullptr;
+    }
+
+    // finds many keys at once, see TreeFuncs::findKeys
+    void findKeys(const TKey* keys, size_t count, const TData** items) const
+    {
+        TreeUtil::findKeys(m_index, m_tree, keys, count, items);
+        StatsUtil::recordMany(m_tree, m_stats, keys, count, items);
+    }
+
+    // the counts of the lookups, if TStats keeps them
+    const TStats& getStats() const { return m_stats; }
+    // the item that findKey gives for a key that is not found, if any
+    const TData* getDefault() const
+    {
+        const TStructItem* item = static_cast<const TStructItem*>(m_tree.getDefault());
         return item ? &(item->data()) : nullptr;
     }
 
@@ -205,8 +292,20 @@ public:
         return seq;
     }
 
+public:
+    // these find items by their place in the order of the keys in O(log n)
+    // time, and work the same as the functions of the same name in TSequence
+    TIterator lowerBound(const TKey& key) const { return sequence().lower_bound(key); }
+    TIterator upperBound(const TKey& key) const { return sequence().upper_bound(key); }
+    std::pair<TIterator, TIterator> equalRange(const TKey& key) const { return sequence().equal_range(key); }
+    TSequence range(const TKey& lo, const TKey& hi) const { return sequence().range(lo, hi); }
+    // all of the items with the key, for a map that keeps repeated keys
+    TSequence findAll(const TKey& key) const { return sequence().range(key); }
+
 private:
     ItemTree m_tree;
+    TIndex m_index;
+    TStats m_stats;
 };
 } // namespace static_map
 #endif /* unimap_hpp */
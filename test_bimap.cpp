@@ -8,7 +8,9 @@
 
 #include "test_bimap.hpp"
 
+#include <cassert>
 #include <iostream>
+#include <string>
 
 #include "bimap.hpp"
 #include "enummap.hpp"
@@ -135,6 +137,45 @@ void testBiMap1()
     std::cout << "Stop Test" << std::endl;
 }
 
+typedef static_map::BiMap<int, int, std::less<int>, std::less<int>, static_map::STreeIndex, static_map::STreeIndex>
+    BSMap;
+typedef BSMap::Item BS;
+
+static BSMap::TBuilder bsb;
+static BS bs1(bsb, 1, 5);
+static BS bs2(bsb, 2, 4);
+static BS bs3(bsb, 0, 0);
+static BS bs4(bsb, 4, 2);
+
+static BSMap::TIndex1::Block bsblocks1[1];
+static BSMap::TIndex2::Block bsblocks2[1];
+static BSMap bsm(bsb, bsblocks1, bsblocks2);
+
+void testBiMapSTree()
+{
+    std::cout << "Start Test BiMap STree" << std::endl;
+
+    for (int i = 0; i <= 5; ++i)
+    {
+        const BS* p1 = bsm.findKey1(i);
+        const BS* p2 = bsm.findKey2(i);
+        std::cout << "find " << i;
+        std::cout << (p1 ? " found1" : " not found1");
+        if (p1)
+        {
+            std::cout << "(k1=" << p1->key1() << " k2=" << p1->key2() << ")";
+        }
+        std::cout << (p2 ? " found2" : " not found2");
+        if (p2)
+        {
+            std::cout << "(k1=" << p2->key1() << " k2=" << p2->key2() << ")";
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "Stop Test" << std::endl;
+}
+
 // in header:
 namespace color
 {
@@ -159,7 +200,9 @@ static Enum<Color>::Item e1(b, Color::RED, "RED");
 static Enum<Color>::Item e2(b, Color::BLUE, "bleu");
 static Enum<Color>::Item e3(b, Color::GREEN, "Green");
 
-static Enum<Color>::Map em(b);
+static Enum<Color>::ValueSlot ev[18];
+// the colors span 18 values for 3 items, so allow up to 6 slots per item
+static Enum<Color>::Map em(b, Enum<Color>::ValueIndex::Storage(ev).withMaxSpanPerItem(6));
 
 static const char* colorToString(Color c)
 {
@@ -195,7 +238,9 @@ static Enum<Shape>::Builder b;
 static Enum<Shape>::Item e1(b, Shape::SQUARE, "square");
 static Enum<Shape>::Item e2(b, Shape::CIRCLE, "circle");
 
-static Enum<Shape>::Map em(b);
+static Enum<Shape>::NameSlot es[Enum<Shape>::NameIndex::slotsFor(2)];
+static Enum<Shape>::ValueSlot ev[2];
+static Enum<Shape>::Map em(b, ev, es);
 
 static const char* shapeToString(Shape c)
 {
@@ -209,6 +254,33 @@ static Shape stringToShape(const char* c)
 }
 } // namespace shape
 
+// in header:
+namespace status
+{
+typedef enum
+{
+    NEW = 0,
+    FILLED = 1,
+    PARTIALLY_FILLED = 2,
+    PARTIALLY_CANCELED = 3
+} Status;
+} // namespace status
+
+// in source:
+namespace status
+{
+using static_map::Enum;
+
+// the names are told apart by what comes after ORDER_STATUS_
+static Enum<Status>::Builder b;
+static Enum<Status>::Item e1(b, Status::PARTIALLY_FILLED, "ORDER_STATUS_PARTIALLY_FILLED");
+static Enum<Status>::Item e2(b, Status::NEW, "ORDER_STATUS_NEW");
+static Enum<Status>::Item e3(b, Status::PARTIALLY_CANCELED, "ORDER_STATUS_PARTIALLY_CANCELED");
+static Enum<Status>::Item e4(b, Status::FILLED, "ORDER_STATUS_FILLED");
+
+static Enum<Status>::Map em(b);
+} // namespace status
+
 void testBiMap2()
 {
     {
@@ -218,6 +290,19 @@ void testBiMap2()
 
         Color c2 = stringToColor("RED");
         std::cout << "are equal:" << (c1 == c2) << std::endl;
+        std::cout << colorToString(Color::BLUE) << " should be bleu" << std::endl;
+        std::cout << colorToString(Color::GREEN) << " should be Green" << std::endl;
+        std::cout << "0 found:" << Enum<Color>::enumToString(em, (Color) 0).first << std::endl;
+        std::cout << "15 found:" << Enum<Color>::enumToString(em, (Color) 15).first << std::endl;
+        // the values are looked up in the slots, not the tree
+        assert(em.getIndex1().isBuilt());
+        std::cout << "value index built:" << em.getIndex1().isBuilt() << std::endl;
+
+        // names that are not NUL terminated are found without a copy
+        const std::string green("Green");
+        std::cout << "Green found:" << Enum<Color>::stringToEnum(em, green).first << std::endl;
+        Enum<Color>::Map::TSequence2 seq = em.sequence2();
+        std::cout << "bl found:" << (seq.find(static_map::StrRef("bleu", 2)) != seq.end()) << std::endl;
     }
     {
         using namespace shape;
@@ -226,6 +311,23 @@ void testBiMap2()
 
         Shape c2 = stringToShape("circle");
         std::cout << "are equal:" << (c1 == c2) << std::endl;
+        std::cout << shapeToString(stringToShape("square")) << " should be square" << std::endl;
+        std::cout << "triangle found:" << Enum<Shape>::stringToEnum(em, "triangle").first << std::endl;
+
+        const char packet[] = "squarecircles";
+        std::cout << shapeToString(Enum<Shape>::stringToEnum(em, packet, 6).second) << " should be square" << std::endl;
+        std::cout << shapeToString(Enum<Shape>::stringToEnum(em, packet + 6, 6).second) << " should be circle" << std::endl;
+        std::cout << "circles found:" << Enum<Shape>::stringToEnum(em, packet + 6, 7).first << std::endl;
+    }
+    {
+        using namespace status;
+        const char* names[] = {"ORDER_STATUS_NEW", "ORDER_STATUS_PARTIALLY_CANCELED", "ORDER_STATUS_PARTIALLY_FILLED",
+                               "ORDER_STATUS_PARTIAL", "ORDER_STATUS_", "ORDER_NEW", ""};
+        for (const char* name : names)
+        {
+            auto p = Enum<Status>::stringToEnum(em, name);
+            std::cout << "\"" << name << "\" found:" << p.first << " value:" << (p.first ? p.second : -1) << std::endl;
+        }
     }
 }
 
@@ -288,3 +390,34 @@ void testBiMap3()
     bi2TraverseFwd(seq2);
     bi2TraverseRev(seq2);
 }
+
+static BIMap::TBuilder db(BIMap::TDuplicates::firstWins());
+static BI d1(db, 1, 10);
+static BI d2(db, 1, 20);
+static BI d3(db, 2, 30);
+static BI d4(db, 3, 30);
+
+static BIMap dm(db);
+
+void testBiMapDuplicates()
+{
+    std::cout << "Start Test BiMap Duplicates" << std::endl;
+
+    // (1,20) is a duplicate of key1 and (3,30) of key2, and each is dropped
+    // from both sides
+    BIMap::TSequence1 seq1 = dm.sequence1();
+    bi1TraverseFwd(seq1);
+    BIMap::TSequence2 seq2 = dm.sequence2();
+    bi2TraverseFwd(seq2);
+
+    const BI* p1 = dm.findKey2(20);
+    std::cout << "find key2 20 " << (p1 ? "found" : "not found") << std::endl;
+    assert(!p1);
+    const BI* p2 = dm.findKey1(3);
+    std::cout << "find key1 3 " << (p2 ? "found" : "not found") << std::endl;
+    assert(!p2);
+    assert(dm.findKey1(1) == &d1 && dm.findKey2(10) == &d1);
+    assert(dm.findKey1(2) == &d3 && dm.findKey2(30) == &d3);
+
+    std::cout << "Stop Test" << std::endl;
+}
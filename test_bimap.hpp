@@ -12,5 +12,7 @@
 void testBiMap1();
 void testBiMap2();
 void testBiMap3();
+void testBiMapSTree();
+void testBiMapDuplicates();
 
 #endif /* test_bimap_hpp */
@@ -0,0 +1,82 @@
+//
+//  test_constmap.cpp
+//  StaticMap
+//
+
+#include "test_constmap.hpp"
+
+#include <iostream>
+
+#include "constmap.hpp"
+
+typedef static_map::ConstMap<int, int, 5> CIMap;
+typedef CIMap::Item CI;
+
+static constexpr CIMap cim(CIMap::TPairs{{{4, 2}, {1, 5}, {2, 4}, {0, 0}, {7, 1}}});
+
+// all of it is done by the compiler
+static_assert(cim.findKey(2)->val() == 4, "find 2");
+static_assert(cim.findKey(3) == nullptr, "find 3");
+static_assert(cim.sequence().begin() == cim.findKey(0), "first is 0");
+
+typedef static_map::ConstMap<const char*, int, 3, static_map::ConstStrLess> CSMap;
+
+static constexpr CSMap csm(CSMap::TPairs{{{"GREEN", 1}, {"BLUE", 14}, {"RED", -3}}});
+
+static_assert(csm.findKey("RED")->val() == -3, "find RED");
+static_assert(csm.table().findKey("BLUE") == csm.findKey("BLUE"), "the same items as a TableMap");
+
+static void ci1FindIt(int i)
+{
+    std::cout << "find " << i;
+    const CI* p = cim.findKey(i);
+    std::cout << (p ? " found" : " not found");
+    if (p)
+    {
+        std::cout << "(k=" << p->key() << " v=" << p->val() << ")";
+    }
+    std::cout << std::endl;
+}
+
+template<typename TIterParam>
+static void ci1Traverse(TIterParam itBegin, TIterParam itEnd)
+{
+    std::cout << "->" << std::endl;
+    for (TIterParam it = itBegin; it != itEnd; ++it)
+    {
+        std::cout << "k=" << it->key() << ", v=" << it->val() << std::endl;
+    }
+    std::cout << "<-" << std::endl;
+    for (TIterParam it = itEnd; it != itBegin; --it)
+    {
+        TIterParam itPrev(it);
+        --itPrev;
+        std::cout << "k=" << itPrev->key() << ", v=" << itPrev->val() << std::endl;
+    }
+}
+
+void testConstMap()
+{
+    std::cout << "Start Test ConstMap" << std::endl;
+
+    CIMap::TSequence seq1 = cim.sequence();
+    std::cout << "FWD";
+    ci1Traverse(seq1.begin(), seq1.end());
+    std::cout << "REV";
+    ci1Traverse(seq1.rbegin(), seq1.rend());
+
+    ci1FindIt(0);
+    ci1FindIt(1);
+    ci1FindIt(3);
+    ci1FindIt(7);
+    ci1FindIt(8);
+
+    CSMap::TSequence seq2 = csm.sequence();
+    for (CSMap::TSequence::const_iterator it = seq2.begin(); it != seq2.end(); ++it)
+    {
+        std::cout << it->key() << "=" << it->val() << std::endl;
+    }
+    std::cout << "find Green" << ((seq2.find("Green") == seq2.end()) ? " not found" : " found") << std::endl;
+
+    std::cout << "Stop Test" << std::endl;
+}
@@ -0,0 +1,11 @@
+//
+//  test_constmap.hpp
+//  StaticMap
+//
+
+#ifndef test_constmap_hpp
+#define test_constmap_hpp
+
+void testConstMap();
+
+#endif /* test_constmap_hpp */
@@ -0,0 +1,199 @@
+//
+//  test_mappedmap.cpp
+//  StaticMap
+//
+
+#include "test_mappedmap.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "bimap.hpp"
+#include "constmap.hpp"
+#include "mappedmap.hpp"
+#include "refmap.hpp"
+#include "unimap.hpp"
+
+typedef static_map::UniMap<int, const char*, std::less<int>> ISMap;
+typedef ISMap::Item IS;
+
+static ISMap::Builder isb;
+static IS is1(isb, 3, "THREE");
+static IS is2(isb, 1, "ONE");
+static IS is3(isb, 7, "SEVEN");
+static IS is4(isb, 5, "ONE");
+
+static ISMap ism(isb);
+
+static ISMap::Builder idb;
+static IS id1(idb, 2, "TWO");
+static IS id2(idb, 4, "UNKNOWN", true);
+static IS id3(idb, 6, "SIX");
+
+static ISMap idm(idb);
+
+// records of a RefMap, with the key and val that write needs
+struct Color
+{
+    int m_code;
+    const char* m_name;
+    const int& key() const { return m_code; }
+    const char* val() const { return m_name; }
+};
+
+typedef static_map::RefMap<Color, int> CRMap;
+
+static const Color s_red = {1, "RED"};
+static const Color s_none = {0, "NONE"};
+static CRMap::Builder crb;
+static CRMap::Item cr1(crb, s_red);
+static CRMap::Item cr2(crb, s_none, true);
+
+static CRMap crm(crb);
+
+typedef static_map::MappedMap<int, const char*> MISMap;
+typedef MISMap::Item MIS;
+
+typedef static_map::BiMap<int, const char*, std::less<int>, static_map::ConstStrLess> BISMap;
+
+static BISMap::TBuilder bisb;
+static BISMap::Item bis1(bisb, 1, "RED");
+static BISMap::Item bis2(bisb, 2, "GREEN");
+static BISMap::LeftKeyItem bis3(bisb, 3, "VERMILION");
+static BISMap::RightKeyItem bis4(bisb, 1, "SCARLET");
+
+static BISMap bism(bisb);
+
+typedef static_map::MappedBiMap<int, const char*, std::less<int>, static_map::ConstStrLess> MBISMap;
+typedef MBISMap::Item MBIS;
+
+static std::string snapshotPath(const char* name)
+{
+    const char* dir = getenv("TMPDIR");
+    return std::string((dir && *dir) ? dir : "/tmp") + "/" + name;
+}
+
+static void misFindIt(const MISMap& map, int i)
+{
+    std::cout << "find " << i;
+    const MIS* p = map.findKey(i);
+    std::cout << (p ? " found" : " not found");
+    if (p)
+    {
+        std::cout << "(k=" << p->key() << " v=" << p->val() << ")";
+    }
+    std::cout << std::endl;
+}
+
+template<typename TIterParam>
+static void misTraverse(TIterParam itBegin, TIterParam itEnd)
+{
+    std::cout << "->" << std::endl;
+    for (TIterParam it = itBegin; it != itEnd; ++it)
+    {
+        std::cout << "k=" << it->key() << ", v=" << it->val() << std::endl;
+    }
+}
+
+template<typename TIterParam>
+static void mbisTraverse(TIterParam itBegin, TIterParam itEnd)
+{
+    std::cout << "->" << std::endl;
+    for (TIterParam it = itBegin; it != itEnd; ++it)
+    {
+        std::cout << "k1=" << it->key1() << ", k2=" << it->key2() << std::endl;
+    }
+}
+
+static void testMappedUniMap()
+{
+    const std::string path = snapshotPath("static_map_test_unimap.snap");
+    std::cout << "write " << (MISMap::write(ism, path.c_str()) ? "ok" : "failed") << std::endl;
+    {
+        MISMap map(path.c_str());
+        std::cout << "open " << (map.isOpen() ? "ok" : "failed") << " size=" << map.size() << std::endl;
+
+        MISMap::TSequence seq = map.sequence();
+        std::cout << "FWD";
+        misTraverse(seq.begin(), seq.end());
+        std::cout << "REV";
+        misTraverse(seq.rbegin(), seq.rend());
+
+        misFindIt(map, 0);
+        misFindIt(map, 1);
+        misFindIt(map, 5);
+        misFindIt(map, 7);
+        misFindIt(map, 8);
+        // the same strings are only written once
+        std::cout << "shared " << ((map.findKey(1)->val() == map.findKey(5)->val()) ? "yes" : "no") << std::endl;
+    }
+    remove(path.c_str());
+
+    // a snapshot of the wrong kind is not used
+    MBISMap::write(bism, path.c_str());
+    {
+        MISMap map(path.c_str());
+        std::cout << "open other " << (map.isOpen() ? "ok" : "failed") << " size=" << map.size() << std::endl;
+        misFindIt(map, 1);
+    }
+    remove(path.c_str());
+
+    MISMap missing(path.c_str());
+    std::cout << "open missing " << (missing.isOpen() ? "ok" : "failed") << std::endl;
+
+    // a key that is not found gives the default item, as in the map written
+    MISMap::write(idm, path.c_str());
+    {
+        MISMap map(path.c_str());
+        std::cout << "open default " << (map.isOpen() ? "ok" : "failed") << std::endl;
+        misFindIt(map, 6);
+        misFindIt(map, 5);
+        std::cout << "same default " << ((map.findKey(5) == map.getDefault()) ? "yes" : "no") << " as "
+                  << ((idm.findKey(5) == idm.getDefault()) ? "yes" : "no") << std::endl;
+    }
+    remove(path.c_str());
+
+    // and so does one of a RefMap
+    MISMap::write(crm, path.c_str());
+    {
+        MISMap map(path.c_str());
+        misFindIt(map, 1);
+        misFindIt(map, 9);
+    }
+    remove(path.c_str());
+}
+
+static void testMappedBiMap()
+{
+    const std::string path = snapshotPath("static_map_test_bimap.snap");
+    std::cout << "write " << (MBISMap::write(bism, path.c_str()) ? "ok" : "failed") << std::endl;
+    {
+        MBISMap map(path.c_str());
+        std::cout << "open " << (map.isOpen() ? "ok" : "failed") << std::endl;
+
+        MBISMap::TSequence1 seq1 = map.sequence1();
+        std::cout << "FWD1";
+        mbisTraverse(seq1.begin(), seq1.end());
+        MBISMap::TSequence2 seq2 = map.sequence2();
+        std::cout << "FWD2";
+        mbisTraverse(seq2.begin(), seq2.end());
+
+        const MBIS* p1 = map.findKey1(3);
+        std::cout << "find1 3 " << (p1 ? p1->key2() : "not found") << std::endl;
+        const MBIS* p2 = map.findKey2("SCARLET");
+        std::cout << "find2 SCARLET " << (p2 ? "found" : "not found") << std::endl;
+        const MBIS* p3 = map.findKey2("VERMILION");
+        std::cout << "find2 VERMILION " << (p3 ? "found" : "not found") << std::endl;
+    }
+    remove(path.c_str());
+}
+
+void testMappedMap()
+{
+    std::cout << "Start Test MappedMap" << std::endl;
+    testMappedUniMap();
+    testMappedBiMap();
+    std::cout << "Stop Test" << std::endl;
+}
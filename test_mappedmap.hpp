@@ -0,0 +1,11 @@
+//
+//  test_mappedmap.hpp
+//  StaticMap
+//
+
+#ifndef test_mappedmap_hpp
+#define test_mappedmap_hpp
+
+void testMappedMap();
+
+#endif /* test_mappedmap_hpp */
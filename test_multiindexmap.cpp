@@ -0,0 +1,108 @@
+//
+//  test_multiindexmap.cpp
+//  StaticMap
+//
+
+#include "test_multiindexmap.hpp"
+
+#include <cassert>
+#include <iostream>
+
+#include "multiindexmap.hpp"
+#include "strref.hpp"
+
+// instruments found by id, ticker or ISIN.  the ids are close together so
+// they are in a dense array, the tickers are hashed and the ISINs are only in
+// their tree
+typedef static_map::MultiIndexMap<const char*,
+                                  static_map::MultiKey<int, std::less<int>, static_map::DenseIndex>,
+                                  static_map::MultiKey<const char*, static_map::StrLess, static_map::PerfectHashIndex>,
+                                  static_map::MultiKey<const char*, static_map::StrLess>>
+    IMap;
+typedef IMap::Item I;
+
+static const size_t ID = 0;
+static const size_t TICKER = 1;
+static const size_t ISIN = 2;
+
+static IMap::TBuilder ib;
+static I i1(ib, "Apple", 104, "AAPL", "US0378331005");
+static I i2(ib, "Microsoft", 101, "MSFT", "US5949181045");
+static I i3(ib, "Nestle", 107, "NESN", "CH0038863350");
+static I i4(ib, "Toyota", 102, "7203", "JP3633400001");
+static I i5(ib, "SAP", 105, "SAP", "DE0007164600");
+
+static IMap::TIndex<ID>::Slot iids[16];
+static IMap::TIndex<TICKER>::Slot itickers[IMap::TIndex<TICKER>::slotsFor(5)];
+static IMap im(ib, iids, itickers, IMap::TIndexStorage<ISIN>());
+
+static void iPrint(const I* p)
+{
+    std::cout << (p ? " found" : " not found");
+    if (p)
+    {
+        std::cout << "(" << p->val() << " id=" << p->key<ID>() << " ticker=" << p->key<TICKER>()
+                  << " isin=" << p->key<ISIN>() << ")";
+    }
+    std::cout << std::endl;
+}
+
+void testMultiIndexMap()
+{
+    std::cout << "Start Test MultiIndexMap" << std::endl;
+
+    std::cout << "size " << im.size() << std::endl;
+    const int ids[] = {101, 103, 107};
+    for (int id : ids)
+    {
+        std::cout << "find id " << id;
+        iPrint(im.findKey<ID>(id));
+    }
+    const char* tickers[] = {"SAP", "7203", "IBM"};
+    for (const char* ticker : tickers)
+    {
+        std::cout << "find ticker " << ticker;
+        iPrint(im.findKey<TICKER>(ticker));
+    }
+    std::cout << "find isin US5949181045";
+    iPrint(im.findKey<ISIN>(static_map::StrRef("US5949181045")));
+
+    std::cout << "by id:";
+    for (const I& item : im.sequence<ID>())
+    {
+        std::cout << " " << item.key<ID>();
+    }
+    std::cout << std::endl;
+    std::cout << "by ticker:";
+    for (const I& item : im.sequence<TICKER>())
+    {
+        std::cout << " " << item.key<TICKER>();
+    }
+    std::cout << std::endl;
+    std::cout << "isin from D to U:";
+    for (const I& item : im.range<ISIN>("D", "U"))
+    {
+        std::cout << " " << item.key<ISIN>();
+    }
+    std::cout << std::endl;
+
+    // an item that is a duplicate by any key is dropped for every key
+    IMap::TBuilder builder(IMap::TDuplicates::firstWins());
+    I d1(builder, "first", 1, "X", "I1");
+    I d2(builder, "same id", 1, "Y", "I2");
+    I d3(builder, "same ticker", 2, "X", "I3");
+    I d4(builder, "same isin", 3, "Z", "I1");
+    IMap dm(builder);
+    std::cout << "duplicates size " << dm.size() << std::endl;
+    const I* drops[] = {dm.findKey<TICKER>("Y"), dm.findKey<ISIN>("I2"), dm.findKey<ID>(2), dm.findKey<ISIN>("I3"),
+                        dm.findKey<ID>(3), dm.findKey<TICKER>("Z")};
+    for (const I* p : drops)
+    {
+        std::cout << "find dropped";
+        iPrint(p);
+        assert(!p);
+    }
+    assert(dm.findKey<ID>(1) == &d1 && dm.findKey<TICKER>("X") == &d1 && dm.findKey<ISIN>("I1") == &d1);
+
+    std::cout << "Stop Test" << std::endl;
+}
@@ -0,0 +1,11 @@
+//
+//  test_multiindexmap.hpp
+//  StaticMap
+//
+
+#ifndef test_multiindexmap_hpp
+#define test_multiindexmap_hpp
+
+void testMultiIndexMap();
+
+#endif /* test_multiindexmap_hpp */
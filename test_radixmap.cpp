@@ -0,0 +1,96 @@
+//
+//  test_radixmap.cpp
+//  StaticMap
+//
+
+#include "test_radixmap.hpp"
+
+#include <iostream>
+
+#include "radixmap.hpp"
+
+typedef static_map::RadixMap<int> RMap;
+typedef RMap::Item R;
+
+static RMap::TBuilder rb;
+static R r1(rb, "/", 1);
+static R r2(rb, "/user", 2);
+static R r3(rb, "/user/settings", 3);
+static R r4(rb, "/users", 4);
+static R r5(rb, "/static", 5);
+static R r6(rb, "get", 6);
+static R r7(rb, "getall", 7);
+static R r8(rb, "go", 8);
+
+static RMap::Node rnodes[RMap::nodesFor(8)];
+static RMap rm(rb, rnodes);
+
+// the same items without the nodes, which goes through the items
+static RMap::TBuilder rbs;
+static R rs1(rbs, "get", 6);
+static R rs2(rbs, "getall", 7);
+static R rs3(rbs, "go", 8);
+
+static RMap rms(rbs);
+
+static void rFindIt(const RMap& m, const char* key)
+{
+    const R* p = m.findKey(key);
+    std::cout << "find " << key << (p ? " found" : " not found");
+    if (p)
+    {
+        std::cout << "(v=" << p->val() << ")";
+    }
+    std::cout << std::endl;
+}
+
+static void rPrefix(const RMap& m, const char* prefix)
+{
+    RMap::TSequence seq = m.prefixRange(prefix);
+    std::cout << "prefix \"" << prefix << "\" ->";
+    for (RMap::TIterator it = seq.begin(); it != seq.end(); ++it)
+    {
+        std::cout << " " << it->key();
+    }
+    std::cout << std::endl;
+}
+
+static void rLongest(const RMap& m, const char* text)
+{
+    const R* p = m.longestMatch(text);
+    std::cout << "longest of " << text << " is " << (p ? p->key() : "none") << std::endl;
+}
+
+void testRadixMap()
+{
+    std::cout << "Start Test RadixMap" << std::endl;
+
+    std::cout << "built:" << rm.isBuilt() << " size:" << rm.size() << std::endl;
+    rFindIt(rm, "/user");
+    rFindIt(rm, "/use");
+    rFindIt(rm, "/user/settings");
+    rFindIt(rm, "getal");
+    rFindIt(rm, "");
+
+    rPrefix(rm, "/user");
+    rPrefix(rm, "/us");
+    rPrefix(rm, "g");
+    rPrefix(rm, "get");
+    rPrefix(rm, "x");
+    rPrefix(rm, "");
+
+    rLongest(rm, "/user/settings/theme");
+    rLongest(rm, "/users/7");
+    rLongest(rm, "/usex");
+    rLongest(rm, "getallnow");
+    rLongest(rm, "gone");
+    rLongest(rm, "nothing");
+
+    std::cout << "built:" << rms.isBuilt() << std::endl;
+    rFindIt(rms, "getall");
+    rFindIt(rms, "g");
+    rPrefix(rms, "ge");
+    rLongest(rms, "getaway");
+
+    std::cout << "Stop Test" << std::endl;
+}
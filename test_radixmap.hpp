@@ -0,0 +1,11 @@
+//
+//  test_radixmap.hpp
+//  StaticMap
+//
+
+#ifndef test_radixmap_hpp
+#define test_radixmap_hpp
+
+void testRadixMap();
+
+#endif /* test_radixmap_hpp */
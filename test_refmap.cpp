@@ -103,3 +103,158 @@ void testRefMap()
 
     std::cout << "Stop Test" << std::endl;
 }
+
+typedef static_map::RefMap<FData, FKey, FKeyGet, std::less<FKey>, static_map::EytzingerIndex> FooFlatMap;
+typedef FooFlatMap::Item FooFlatItem;
+typedef FooFlatMap::Builder FooFlatBuilder;
+
+static FooFlatBuilder ffb;
+static FooFlatItem ffi1(ffb, f1);
+static FooFlatItem ffi2(ffb, f2);
+static FooFlatItem ffi3(ffb, f3);
+static FooFlatItem ffi4(ffb, f4);
+
+static FooFlatMap::TIndex::Slot ffslots[4];
+static FooFlatMap ffm(ffb, ffslots);
+
+static void ffmFindIt(int i)
+{
+    std::cout << "find " << i;
+    const Foo* p = ffm.findKey(i);
+    std::cout << (p ? " found" : " not found");
+    if (p)
+    {
+        std::cout << "(x=" << p->m_x << " y=" << p->m_y << ")";
+    }
+    std::cout << std::endl;
+}
+
+void testRefMapEytzinger()
+{
+    std::cout << "Start Test RefMap Eytzinger" << std::endl;
+
+    ffmFindIt(0);
+    ffmFindIt(1);
+    ffmFindIt(2);
+    ffmFindIt(3);
+    ffmFindIt(4);
+    ffmFindIt(5);
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+static void fmLowerUpper(int i)
+{
+    std::cout << "bounds " << i;
+    FooMap::TIterator lower = fm.lowerBound(i);
+    FooMap::TIterator upper = fm.upperBound(i);
+    FooSequence seq = fm.sequence();
+    std::cout << " lower=";
+    if (lower != seq.end())
+        std::cout << lower->m_i;
+    else
+        std::cout << "end";
+    std::cout << " upper=";
+    if (upper != seq.end())
+        std::cout << upper->m_i;
+    else
+        std::cout << "end";
+    std::cout << std::endl;
+}
+
+static void fmRange(int lo, int hi)
+{
+    std::cout << "range " << lo << " " << hi << std::endl;
+    FooSequence seq = fm.range(lo, hi);
+    fmTraverseFwd(seq);
+    fmTraverseRev(seq);
+}
+
+void testRefMapRange()
+{
+    std::cout << "Start Test RefMap Range" << std::endl;
+
+    fmLowerUpper(0);
+    fmLowerUpper(2);
+    fmLowerUpper(4);
+    fmLowerUpper(5);
+
+    std::pair<FooMap::TIterator, FooMap::TIterator> equal = fm.equalRange(3);
+    for (FooMap::TIterator it = equal.first; it != equal.second; ++it)
+    {
+        std::cout << "equal " << it->m_i << " x=" << it->m_x << std::endl;
+    }
+
+    fmRange(2, 4);
+    fmRange(0, 9);
+    fmRange(3, 3);
+    fmRange(5, 9);
+
+    // a range of a range only has what is in both
+    FooSequence inner = fm.range(2, 5).range(0, 4);
+    fmTraverseFwd(inner);
+    std::cout << "find 1 in range" << (inner.find(1) != inner.end() ? " found" : " not found") << std::endl;
+    std::cout << "find 3 in range" << (inner.find(3) != inner.end() ? " found" : " not found") << std::endl;
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+// several items with the same key, like the handlers of each category, kept
+// in the order they were added
+static Foo h1(2, 1.0, 0.0);
+static Foo h2(1, 2.0, 0.0);
+static Foo h3(2, 3.0, 0.0);
+static Foo h4(3, 4.0, 0.0);
+static Foo h5(2, 5.0, 0.0);
+static Foo h6(1, 6.0, 0.0);
+
+static FooBuilder hb(FooMap::TDuplicates::keepInOrder());
+static FooItem hi1(hb, h1);
+static FooItem hi2(hb, h2);
+static FooItem hi3(hb, h3);
+static FooItem hi4(hb, h4);
+static FooItem hi5(hb, h5);
+static FooItem hi6(hb, h6);
+
+static FooMap hm(hb);
+
+// the same with a perfect hash, which finds the first of each key
+typedef static_map::RefMap<FData, FKey, FKeyGet, std::less<FKey>, static_map::PerfectHashIndex> FooHashMap;
+
+static FooHashMap::Builder hhb(FooHashMap::TDuplicates::keepInOrder());
+static FooHashMap::Item hhi1(hhb, h1);
+static FooHashMap::Item hhi2(hhb, h2);
+static FooHashMap::Item hhi3(hhb, h3);
+static FooHashMap::Item hhi4(hhb, h4);
+static FooHashMap::Item hhi5(hhb, h5);
+static FooHashMap::Item hhi6(hhb, h6);
+
+static FooHashMap::TIndex::Slot hhslots[FooHashMap::TIndex::slotsFor(6)];
+static FooHashMap hhm(hhb, hhslots);
+
+static void hmFindAll(int i)
+{
+    std::cout << "find all " << i << ":";
+    FooSequence all = hm.findAll(i);
+    for (FooSequence::const_iterator it = all.begin(); it != all.end(); ++it)
+    {
+        std::cout << " x=" << it->m_x;
+    }
+    const Foo* first = hm.findKey(i);
+    const Foo* hashFirst = hhm.findKey(i);
+    std::cout << " first=" << (first ? first->m_x : 0.0) << " hash first=" << (hashFirst ? hashFirst->m_x : 0.0)
+              << std::endl;
+}
+
+void testRefMapMulti()
+{
+    std::cout << "Start Test RefMap Multi" << std::endl;
+
+    hmFindAll(0);
+    hmFindAll(1);
+    hmFindAll(2);
+    hmFindAll(3);
+    hmFindAll(4);
+
+    std::cout << "Stop Test" << std::endl;
+}
@@ -10,5 +10,8 @@
 #define test_refmap_hpp
 
 void testRefMap();
+void testRefMapEytzinger();
+void testRefMapRange();
+void testRefMapMulti();
 
 #endif /* test_refmap_hpp */
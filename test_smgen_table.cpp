@@ -0,0 +1,21 @@
+//
+//  test_smgen_table.cpp
+//  generated by smgen from test_smgen.csv, do not edit
+//
+
+#include "test_smgen_table.hpp"
+
+namespace
+{
+
+// 4 rows, sorted by key
+constexpr HttpStatusMap::Item s_items[] = {
+    {-1, "Unknown, or \"no reply\""},
+    {200, "OK"},
+    {0x12c, "Multiple Choices"},
+    {404, "Not Found"},
+};
+
+} // namespace
+
+constexpr HttpStatusMap g_httpStatus(s_items);
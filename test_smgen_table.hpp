@@ -0,0 +1,15 @@
+//
+//  test_smgen_table.hpp
+//  generated by smgen from test_smgen.csv, do not edit
+//
+
+#ifndef test_smgen_table_hpp
+#define test_smgen_table_hpp
+
+#include "tablemap.hpp"
+
+typedef static_map::TableMap<int, const char*> HttpStatusMap;
+
+extern const HttpStatusMap g_httpStatus;
+
+#endif /* test_smgen_table_hpp */
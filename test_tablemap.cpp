@@ -0,0 +1,93 @@
+//
+//  test_tablemap.cpp
+//  StaticMap
+//
+
+#include "test_tablemap.hpp"
+
+#include <iostream>
+
+#include "constmap.hpp"
+#include "tablemap.hpp"
+#include "test_smgen_table.hpp"
+
+typedef static_map::TableMap<int, const char*> ISMap;
+typedef ISMap::Item IS;
+
+// laid out the way smgen writes it
+static constexpr IS s_isItems[] = {
+    {-40, "MINUS FORTY"},
+    {-3, "MINUS THREE"},
+    {2, "TWO"},
+    {7, "SEVEN"},
+    {16, "SIXTEEN"},
+};
+
+static constexpr ISMap ism(s_isItems);
+
+static_assert(ism.findKey(7) == s_isItems + 3, "find 7");
+static_assert(ism.findKey(3) == nullptr, "find 3");
+
+typedef static_map::TableMap<const char*, int, static_map::ConstStrLess> SIMap;
+
+static constexpr SIMap::Item s_siItems[] = {{"a", 2}, {"ab", 3}, {"b", 1}};
+
+static constexpr SIMap sim(s_siItems);
+
+static void isFindIt(int i)
+{
+    std::cout << "find " << i;
+    const IS* p = ism.findKey(i);
+    std::cout << (p ? " found" : " not found");
+    if (p)
+    {
+        std::cout << "(k=" << p->key() << " v=" << p->val() << ")";
+    }
+    std::cout << std::endl;
+}
+
+template<typename TIterParam>
+static void isTraverse(TIterParam itBegin, TIterParam itEnd)
+{
+    std::cout << "->" << std::endl;
+    for (TIterParam it = itBegin; it != itEnd; ++it)
+    {
+        std::cout << "k=" << it->key() << ", v=" << it->val() << std::endl;
+    }
+}
+
+void testTableMap()
+{
+    std::cout << "Start Test TableMap" << std::endl;
+
+    ISMap::TSequence seq1 = ism.sequence();
+    std::cout << "FWD";
+    isTraverse(seq1.begin(), seq1.end());
+    std::cout << "REV";
+    isTraverse(seq1.rbegin(), seq1.rend());
+
+    isFindIt(-40);
+    isFindIt(-4);
+    isFindIt(2);
+    isFindIt(16);
+    isFindIt(17);
+
+    SIMap::TSequence seq2 = sim.sequence();
+    for (SIMap::TSequence::const_iterator it = seq2.begin(); it != seq2.end(); ++it)
+    {
+        std::cout << it->key() << "=" << it->val() << std::endl;
+    }
+    std::cout << "find ab" << ((seq2.find("ab") == seq2.end()) ? " not found" : " found") << std::endl;
+    std::cout << "find c" << ((seq2.find("c") == seq2.end()) ? " not found" : " found") << std::endl;
+
+    // written by smgen from tools/test_smgen.csv, see tools/test_smgen.sh
+    std::cout << "smgen " << g_httpStatus.size() << " rows" << std::endl;
+    for (const HttpStatusMap::Item& item : g_httpStatus.sequence())
+    {
+        std::cout << "k=" << item.key() << ", v=" << item.val() << std::endl;
+    }
+    const HttpStatusMap::Item* p = g_httpStatus.findKey(300);
+    std::cout << "find 300 " << (p ? p->val() : "not found") << std::endl;
+
+    std::cout << "Stop Test" << std::endl;
+}
@@ -0,0 +1,11 @@
+//
+//  test_tablemap.hpp
+//  StaticMap
+//
+
+#ifndef test_tablemap_hpp
+#define test_tablemap_hpp
+
+void testTableMap();
+
+#endif /* test_tablemap_hpp */
@@ -9,7 +9,9 @@
 #include "test_unimap.hpp"
 
 #include <iostream>
+#include <stdexcept>
 
+#include "lazymap.hpp"
 #include "unimap.hpp"
 
 typedef static_map::UniMap<int, int, std::less<int>> IIMap;
@@ -81,3 +83,399 @@ void testUniMap()
 
     std::cout << "Stop Test" << std::endl;
 }
+
+typedef static_map::UniMap<int, int, std::less<int>, static_map::EytzingerIndex> IEMap;
+typedef IEMap::Item IE;
+typedef IEMap::Builder IEBuilder;
+
+static IEBuilder eb;
+static IE e1(eb, 7, 70);
+static IE e2(eb, 3, 30);
+static IE e3(eb, 0, 0, true);
+static IE e4(eb, 9, 90);
+static IE e5(eb, 1, 10);
+static IE e6(eb, 5, 50);
+
+static IEMap::TIndex::Slot es[8];
+static IEMap em(eb, es);
+
+static void ie1FindIt(int i)
+{
+    std::cout << "find " << i;
+    const IE* p = em.findKey(i);
+    std::cout << (p ? " found" : " not found");
+    if (p)
+    {
+        std::cout << "(k=" << p->key() << " v=" << p->val() << ")";
+    }
+    std::cout << std::endl;
+}
+
+void testUniMapEytzinger()
+{
+    std::cout << "Start Test UniMap Eytzinger" << std::endl;
+
+    for (int i = -1; i <= 10; ++i)
+    {
+        ie1FindIt(i);
+    }
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+typedef static_map::UniMap<int, int, std::less<int>, static_map::STreeIndex> ISMap;
+typedef ISMap::Item IS;
+typedef ISMap::Builder ISBuilder;
+
+static ISBuilder sb;
+static IS s1(sb, 34, 1);
+static IS s2(sb, 2, 2);
+static IS s3(sb, 55, 3);
+static IS s4(sb, 13, 4);
+static IS s5(sb, 89, 5);
+static IS s6(sb, 5, 6);
+static IS s7(sb, 21, 7);
+static IS s8(sb, 3, 8);
+static IS s9(sb, 144, 9);
+static IS s10(sb, 8, 10);
+static IS s11(sb, 1, 11);
+static IS s12(sb, 233, 12);
+static IS s13(sb, 377, 13);
+static IS s14(sb, 610, 14);
+static IS s15(sb, 987, 15);
+static IS s16(sb, 1597, 16);
+static IS s17(sb, 2584, 17);
+static IS s18(sb, 4181, 18);
+
+static ISMap::TIndex::Block sblocks[ISMap::TIndex::blocksFor(18)];
+static ISMap sm(sb, sblocks);
+
+static void is1FindIt(int i)
+{
+    std::cout << "find " << i;
+    const IS* p = sm.findKey(i);
+    std::cout << (p ? " found" : " not found");
+    if (p)
+    {
+        std::cout << "(k=" << p->key() << " v=" << p->val() << ")";
+    }
+    std::cout << std::endl;
+}
+
+void testUniMapSTree()
+{
+    std::cout << "Start Test UniMap STree" << std::endl;
+
+    is1FindIt(0);
+    is1FindIt(1);
+    is1FindIt(4);
+    is1FindIt(89);
+    is1FindIt(90);
+    is1FindIt(610);
+    is1FindIt(4181);
+    is1FindIt(5000);
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+typedef static_map::UniMap<int, int, std::less<int>, static_map::PerfectHashIndex> IHMap;
+typedef IHMap::Item IH;
+typedef IHMap::Builder IHBuilder;
+
+static IHBuilder hb;
+static IH h1(hb, 700, 7);
+static IH h2(hb, -30, 3);
+static IH h3(hb, 0, 0, true);
+static IH h4(hb, 90000, 9);
+static IH h5(hb, 1, 1);
+static IH h6(hb, 55, 5);
+
+static IHMap::TIndex::Slot hs[IHMap::TIndex::slotsFor(6)];
+static IHMap hm(hb, hs);
+
+static void ih1FindIt(int i)
+{
+    std::cout << "find " << i;
+    const IH* p = hm.findKey(i);
+    std::cout << (p ? " found" : " not found");
+    if (p)
+    {
+        std::cout << "(k=" << p->key() << " v=" << p->val() << ")";
+    }
+    std::cout << std::endl;
+}
+
+void testUniMapPerfectHash()
+{
+    std::cout << "Start Test UniMap PerfectHash" << std::endl;
+
+    ih1FindIt(-30);
+    ih1FindIt(0);
+    ih1FindIt(1);
+    ih1FindIt(2);
+    ih1FindIt(55);
+    ih1FindIt(700);
+    ih1FindIt(90000);
+    ih1FindIt(90001);
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+template<typename TMap>
+static void findKeysOf(const char* name, const TMap& map, const int* keys, size_t count)
+{
+    const typename TMap::Item* items[64];
+    map.findKeys(keys, count, items);
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::cout << name << " find " << keys[i];
+        std::cout << (items[i] ? " found" : " not found");
+        if (items[i])
+        {
+            std::cout << "(k=" << items[i]->key() << " v=" << items[i]->val() << ")";
+        }
+        std::cout << std::endl;
+    }
+}
+
+void testUniMapFindKeys()
+{
+    std::cout << "Start Test UniMap FindKeys" << std::endl;
+
+    // more keys than are searched for at once, so that it takes two batches
+    int keys[40];
+    for (int i = 0; i < 40; ++i)
+    {
+        keys[i] = (i * 7) % 40;
+    }
+    findKeysOf("tree", im, keys, 8);
+    findKeysOf("eytzinger", em, keys, 12);
+    findKeysOf("stree", sm, keys, 40);
+
+    const int hashKeys[] = {-30, 0, 2, 55, 90000, 90001};
+    findKeysOf("perfecthash", hm, hashKeys, 6);
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+typedef static_map::LazyMap<IIMap> LIIMap;
+
+static IIBuilder lb;
+// the map can come before its items
+static LIIMap lm(lb);
+static II l1(lb, 20, 2);
+static II l2(lb, 10, 1);
+static II l3(lb, 30, 3);
+
+static IEBuilder leb;
+static IEMap::TIndex::Slot les[4];
+static void makeLazyEytzinger(void* place, IEBuilder& builder)
+{
+    new (place) IEMap(builder, les);
+}
+static static_map::LazyMap<IEMap> lem(leb, makeLazyEytzinger);
+static IE le1(leb, 4, 40);
+static IE le2(leb, 2, 20);
+
+static IIBuilder ltb;
+static int s_lazyTries = 0;
+static void makeLazyOnSecondTry(void* place, IIBuilder& builder)
+{
+    // fails before it uses the builder, so the next try can
+    if (++s_lazyTries == 1)
+        throw std::runtime_error("not yet");
+    new (place) IIMap(builder);
+}
+static LIIMap ltm(ltb, makeLazyOnSecondTry);
+static II lt1(ltb, 5, 50);
+
+void testUniMapLazy()
+{
+    std::cout << "Start Test UniMap Lazy" << std::endl;
+
+    std::cout << "built " << (lm.isBuilt() ? "yes" : "no") << std::endl;
+    const II* p = lm->findKey(20);
+    std::cout << "find 20 " << (p ? p->val() : -1) << std::endl;
+    std::cout << "built " << (lm.isBuilt() ? "yes" : "no") << std::endl;
+    IIMap::TSequence seq = lm->sequence();
+    ii1TraverseFwd(seq);
+
+    lem.build();
+    std::cout << "built " << (lem.isBuilt() ? "yes" : "no") << std::endl;
+    for (int i = 1; i <= 4; ++i)
+    {
+        const IE* e = lem->findKey(i);
+        std::cout << "find " << i << " " << (e ? e->val() : -1) << std::endl;
+    }
+
+    try
+    {
+        ltm.build();
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cout << "build threw " << e.what() << std::endl;
+    }
+    std::cout << "built " << (ltm.isBuilt() ? "yes" : "no") << std::endl;
+    const II* t = ltm->findKey(5);
+    std::cout << "find 5 " << (t ? t->val() : -1) << " tries " << s_lazyTries << std::endl;
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+static IIBuilder fb(IIMap::TDuplicates::firstWins());
+static II f1(fb, 3, 30);
+static II f2(fb, 1, 10);
+static II f3(fb, 3, 31);
+static II f4(fb, 2, 20);
+static II f5(fb, 3, 32);
+
+static IIMap fm(fb);
+
+static int s_duplicates = 0;
+static bool countDuplicate(const II& kept, const II& duplicate)
+{
+    std::cout << "duplicate k=" << duplicate.key() << " v=" << duplicate.val() << " of v=" << kept.val() << std::endl;
+    ++s_duplicates;
+    // keep the odd values
+    return (duplicate.val() % 2) == 0;
+}
+
+void testUniMapDuplicates()
+{
+    std::cout << "Start Test UniMap Duplicates" << std::endl;
+
+    IIMap::TSequence seq1 = fm.sequence();
+    ii1TraverseFwd(seq1);
+
+    IIBuilder builder(IIMap::TDuplicates::callback(countDuplicate));
+    II c1(builder, 5, 50);
+    II c2(builder, 5, 51);
+    II c3(builder, 4, 40);
+    II c4(builder, 5, 52);
+    IIMap map(builder);
+    std::cout << "duplicates=" << s_duplicates << std::endl;
+    IIMap::TSequence seq2 = map.sequence();
+    ii1TraverseFwd(seq2);
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+typedef static_map::UniMap<int, int, std::less<int>, static_map::TreeIndex, static_map::LookupStats> CIIMap;
+typedef CIIMap::Item CII;
+
+static CIIMap::TBuilder cb;
+static CII c1(cb, 10, 1);
+static CII c2(cb, 20, 2);
+static CII c3(cb, 30, 3);
+static CII c4(cb, 40, 4, true);
+static CII c5(cb, 50, 5);
+
+static CIIMap cm(cb, CIIMap::TIndexStorage(), "counted");
+
+void testUniMapStats()
+{
+    std::cout << "Start Test UniMap Stats" << std::endl;
+
+    // the default item is only a hit when it is looked for
+    const int keys[] = {30, 10, 50, 40, 35, 0};
+    for (int key : keys)
+    {
+        const CII* p = cm.findKey(key);
+        std::cout << "find " << key << " " << (p ? p->val() : -1) << std::endl;
+    }
+    const CII* found[3];
+    cm.findKeys(keys, 3, found);
+
+    static_map::LookupCounts counts = cm.getStats().getCounts();
+    std::cout << "lookups=" << counts.m_lookups << " misses=" << counts.m_misses << " defaults=" << counts.m_defaults
+              << std::endl;
+    static_map::LookupStats::dumpAll(std::cout);
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+// almost every lookup is for 70
+static uint64_t hitsOf(const CII& item)
+{
+    return (item.key() == 70) ? 90 : 1;
+}
+
+static CIIMap::TBuilder wb(CIIMap::TWeights::byWeight(hitsOf));
+static CII w1(wb, 10, 1);
+static CII w2(wb, 20, 2);
+static CII w3(wb, 30, 3);
+static CII w4(wb, 40, 4);
+static CII w5(wb, 50, 5);
+static CII w6(wb, 60, 6);
+static CII w7(wb, 70, 7);
+static CII w8(wb, 80, 8);
+static CII w9(wb, 90, 9);
+
+static CIIMap wm(wb, CIIMap::TIndexStorage(), "weighted");
+
+// the number of items looked at to find the key
+static size_t depthOf(const CIIMap& map, int key)
+{
+    const static_map::LookupCounts before = map.getStats().getCounts();
+    map.findKey(key);
+    const static_map::LookupCounts after = map.getStats().getCounts();
+    for (size_t d = 0; d < static_map::LookupCounts::s_depthCount; ++d)
+    {
+        if (after.m_depths[d] != before.m_depths[d])
+            return d;
+    }
+    return 0;
+}
+
+void testUniMapWeights()
+{
+    std::cout << "Start Test UniMap Weights" << std::endl;
+
+    for (int key = 10; key <= 90; key += 10)
+    {
+        std::cout << "depth of " << key << " " << depthOf(wm, key) << std::endl;
+    }
+    CIIMap::TSequence seq = wm.sequence();
+    for (CIIMap::TIterator it = seq.begin(); it != seq.end(); ++it)
+    {
+        std::cout << it->key() << " ";
+    }
+    std::cout << std::endl;
+
+    std::cout << "Stop Test" << std::endl;
+}
+
+// the perfect hash map ranked, and a range of it ranked without an array
+static IHMap::TRanked::Slot hrslots[6];
+static IHMap::TRanked hr(hm.sequence(), hrslots);
+
+void testUniMapRanked()
+{
+    std::cout << "Start Test UniMap Ranked" << std::endl;
+
+    std::cout << "size " << hr.size() << (hr.isBuilt() ? " built" : " not built") << std::endl;
+    for (size_t k = 0; k < hr.size(); ++k)
+    {
+        std::cout << "nth " << k << " k=" << hr.nth(k).key() << std::endl;
+    }
+    const int keys[] = {-31, -30, 2, 55, 90001};
+    for (int key : keys)
+    {
+        std::cout << "rank " << key << " " << hr.rank(key) << std::endl;
+    }
+    // the second page of two items
+    std::cout << "page";
+    for (IHMap::TRanked::const_iterator it = hr.begin() + 2; it != hr.begin() + 4; ++it)
+    {
+        std::cout << " " << it->key();
+    }
+    std::cout << std::endl;
+    std::cout << "upper_bound 1 at " << (hr.upper_bound(1) - hr.begin()) << std::endl;
+
+    IHMap::TRanked inner(hm.range(0, 700));
+    std::cout << "inner size " << inner.size() << (inner.isBuilt() ? " built" : " not built") << " nth 2 k="
+              << inner.nth(2).key() << " rank 55 " << inner.rank(55) << std::endl;
+
+    std::cout << "Stop Test" << std::endl;
+}
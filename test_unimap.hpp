@@ -10,5 +10,14 @@
 #define test_unimap_hpp
 
 void testUniMap();
+void testUniMapEytzinger();
+void testUniMapSTree();
+void testUniMapPerfectHash();
+void testUniMapFindKeys();
+void testUniMapLazy();
+void testUniMapDuplicates();
+void testUniMapStats();
+void testUniMapWeights();
+void testUniMapRanked();
 
 #endif /* test_unimap_hpp */
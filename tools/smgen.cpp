@@ -0,0 +1,415 @@
+//
+//  smgen.cpp
+//  StaticMap
+//
+
+//
+// smgen: writes a TableMap from a table, so that big tables do not have to
+// be written by hand as Items and are not sorted when the process starts.
+// It reads a CSV file of key,value rows, sorts the rows by key, checks that
+// no key is repeated, and writes a header declaring the map and a cpp file
+// defining it over a constexpr array of the sorted items:
+//
+// smgen --type ColorNames --map g_colorNames --key int --val "const char*" colors.csv color_names
+//
+// makes color_names.hpp and color_names.cpp with:
+//
+// typedef static_map::TableMap<int, const char*> ColorNames;
+// extern const ColorNames g_colorNames;
+//
+// The keys are numbers or C strings ("const char*").  Numbers are sorted by
+// value with std::less, and strings are sorted by their bytes like strcmp
+// with ConstStrLess.  The values are C strings, which are quoted, or are
+// written as they are, so they can be numbers, enumerators or any other
+// constant expression of the value type.
+//
+// In the CSV file, fields may be quoted with ", and "" in a quoted field is
+// a ".  Blank lines and lines starting with # are skipped, and --skip-header
+// skips the first row.
+//
+// It is built on its own, with nothing else from the library:
+//
+// c++ -std=c++14 -O2 tools/smgen.cpp -o smgen
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Options
+{
+    std::string m_type;
+    std::string m_map;
+    std::string m_key;
+    std::string m_val;
+    std::string m_input;
+    std::string m_output;
+    bool m_skipHeader = false;
+};
+
+struct Row
+{
+    std::string m_key;
+    std::string m_val;
+    // the line in the input, for errors
+    size_t m_line = 0;
+    // the key as a number, when the keys are numbers
+    bool m_negative = false;
+    uint64_t m_magnitude = 0;
+};
+
+void usage()
+{
+    std::cerr << "usage: smgen --type TYPE --map NAME --key KEYTYPE --val VALTYPE [--skip-header] INPUT.csv OUTPUT"
+              << std::endl
+              << "writes OUTPUT.hpp and OUTPUT.cpp with a static_map::TableMap of the rows of INPUT.csv" << std::endl;
+}
+
+bool parseOptions(int argc, const char* argv[], Options& options)
+{
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        std::string* value = nullptr;
+        if (arg == "--type")
+            value = &options.m_type;
+        else if (arg == "--map")
+            value = &options.m_map;
+        else if (arg == "--key")
+            value = &options.m_key;
+        else if (arg == "--val")
+            value = &options.m_val;
+        else if (arg == "--skip-header")
+            options.m_skipHeader = true;
+        else if (arg.compare(0, 2, "--") == 0)
+            return false;
+        else
+            files.push_back(arg);
+
+        if (value)
+        {
+            if (++i == argc)
+                return false;
+            *value = argv[i];
+        }
+    }
+    if (files.size() != 2 || options.m_type.empty() || options.m_map.empty() || options.m_key.empty() ||
+        options.m_val.empty())
+        return false;
+    options.m_input = files[0];
+    options.m_output = files[1];
+    return true;
+}
+
+// true if the type is const char* however it is spaced
+bool isStringType(const std::string& type)
+{
+    std::string squeezed;
+    for (char c : type)
+    {
+        if (c != ' ' && c != '\t')
+            squeezed += c;
+    }
+    return squeezed == "constchar*" || squeezed == "charconst*";
+}
+
+std::string trim(const std::string& text)
+{
+    const size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+        return std::string();
+    const size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// splits a CSV record into fields, reading more lines if a quoted field
+// goes over the end of the line
+bool readRecord(std::istream& in, std::string line, size_t& lineNumber, std::vector<std::string>& fields)
+{
+    fields.clear();
+    std::string field;
+    bool quoted = false;
+    bool wasQuoted = false;
+    size_t i = 0;
+    for (;;)
+    {
+        if (i == line.size())
+        {
+            if (!quoted)
+                break;
+            // a quoted field with a line break in it
+            if (!std::getline(in, line))
+                return false;
+            ++lineNumber;
+            field += '\n';
+            i = 0;
+            continue;
+        }
+        const char c = line[i++];
+        if (quoted)
+        {
+            if (c != '"')
+                field += c;
+            else if (i < line.size() && line[i] == '"')
+                field += line[i++];
+            else
+                quoted = false;
+        }
+        else if (c == '"')
+        {
+            quoted = true;
+            wasQuoted = true;
+        }
+        else if (c == ',')
+        {
+            fields.push_back(wasQuoted ? field : trim(field));
+            field.clear();
+            wasQuoted = false;
+        }
+        else
+        {
+            field += c;
+        }
+    }
+    fields.push_back(wasQuoted ? field : trim(field));
+    return true;
+}
+
+bool readRows(const Options& options, std::vector<Row>& rows)
+{
+    std::ifstream in(options.m_input.c_str());
+    if (!in)
+    {
+        std::cerr << options.m_input << ": cannot open: " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::string line;
+    size_t lineNumber = 0;
+    bool skip = options.m_skipHeader;
+    std::vector<std::string> fields;
+    while (std::getline(in, line))
+    {
+        const size_t start = ++lineNumber;
+        const std::string text = trim(line);
+        if (text.empty() || text[0] == '#')
+            continue;
+        if (!readRecord(in, line, lineNumber, fields))
+        {
+            std::cerr << options.m_input << ":" << start << ": quote is not closed" << std::endl;
+            return false;
+        }
+        if (skip)
+        {
+            skip = false;
+            continue;
+        }
+        if (fields.size() != 2)
+        {
+            std::cerr << options.m_input << ":" << start << ": expected 2 fields, found " << fields.size()
+                      << std::endl;
+            return false;
+        }
+        Row row;
+        row.m_key = fields[0];
+        row.m_val = fields[1];
+        row.m_line = start;
+        rows.push_back(row);
+    }
+    return true;
+}
+
+// reads a whole decimal, hex or octal integer into sign and magnitude
+bool parseNumber(Row& row)
+{
+    const std::string& text = row.m_key;
+    if (text.empty())
+        return false;
+    const bool negative = text[0] == '-';
+    const char* digits = text.c_str() + (negative ? 1 : 0);
+    if (!*digits || *digits == '-' || *digits == '+' || *digits == ' ')
+        return false;
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long value = strtoull(digits, &end, 0);
+    if (errno != 0 || *end != '\0')
+        return false;
+    row.m_negative = negative && value != 0;
+    row.m_magnitude = value;
+    return true;
+}
+
+bool numberLess(const Row& r1, const Row& r2)
+{
+    if (r1.m_negative != r2.m_negative)
+        return r1.m_negative;
+    return r1.m_negative ? (r1.m_magnitude > r2.m_magnitude) : (r1.m_magnitude < r2.m_magnitude);
+}
+
+// the same order as ConstStrLess
+bool stringLess(const Row& r1, const Row& r2)
+{
+    return strcmp(r1.m_key.c_str(), r2.m_key.c_str()) < 0;
+}
+
+// writes a C string literal, with octal escapes so that no following
+// character can be read as part of an escape
+std::string quote(const std::string& text)
+{
+    std::string out = "\"";
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += static_cast<char>(c);
+        }
+        else if (c < 0x20 || c >= 0x7f)
+        {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\%03o", c);
+            out += escape;
+        }
+        else
+        {
+            out += static_cast<char>(c);
+        }
+    }
+    return out + "\"";
+}
+
+// the name of the file without its directories
+std::string baseName(const std::string& path)
+{
+    const size_t slash = path.find_last_of('/');
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+std::string guardOf(const std::string& name)
+{
+    std::string guard;
+    for (char c : name)
+    {
+        const bool isWord = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+        guard += isWord ? c : '_';
+    }
+    return guard + "_hpp";
+}
+
+bool writeFile(const std::string& path, const std::string& text)
+{
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out << text;
+    out.close();
+    if (!out)
+    {
+        std::cerr << path << ": cannot write: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool writeOutput(const Options& options, const std::vector<Row>& rows, bool stringKeys, bool stringVals)
+{
+    const std::string name = baseName(options.m_output);
+    const std::string mapType = "static_map::TableMap<" + options.m_key + ", " + options.m_val +
+        (stringKeys ? ", static_map::ConstStrLess>" : ">");
+    const std::string banner = "//\n//  " + name + "%s\n//  generated by smgen from " + baseName(options.m_input) +
+        ", do not edit\n//\n\n";
+
+    std::ostringstream hpp;
+    std::string top = banner;
+    top.replace(top.find("%s"), 2, ".hpp");
+    hpp << top;
+    hpp << "#ifndef " << guardOf(name) << "\n#define " << guardOf(name) << "\n\n";
+    if (stringKeys)
+        hpp << "#include \"constmap.hpp\"\n";
+    hpp << "#include \"tablemap.hpp\"\n\n";
+    hpp << "typedef " << mapType << " " << options.m_type << ";\n\n";
+    hpp << "extern const " << options.m_type << " " << options.m_map << ";\n\n";
+    hpp << "#endif /* " << guardOf(name) << " */\n";
+
+    std::ostringstream cpp;
+    top = banner;
+    top.replace(top.find("%s"), 2, ".cpp");
+    cpp << top;
+    cpp << "#include \"" << name << ".hpp\"\n\n";
+    cpp << "namespace\n{\n\n";
+    cpp << "// " << rows.size() << " rows, sorted by key\n";
+    cpp << "constexpr " << options.m_type << "::Item s_items[] = {\n";
+    for (const Row& row : rows)
+    {
+        cpp << "    {" << (stringKeys ? quote(row.m_key) : row.m_key) << ", "
+            << (stringVals ? quote(row.m_val) : row.m_val) << "},\n";
+    }
+    cpp << "};\n\n";
+    cpp << "} // namespace\n\n";
+    cpp << "constexpr " << options.m_type << " " << options.m_map << "(s_items);\n";
+
+    return writeFile(options.m_output + ".hpp", hpp.str()) && writeFile(options.m_output + ".cpp", cpp.str());
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage();
+        return 2;
+    }
+
+    std::vector<Row> rows;
+    if (!readRows(options, rows))
+        return 1;
+    if (rows.empty())
+    {
+        // a TableMap can be empty, but an array cannot
+        std::cerr << options.m_input << ": no rows" << std::endl;
+        return 1;
+    }
+
+    const bool stringKeys = isStringType(options.m_key);
+    const bool stringVals = isStringType(options.m_val);
+    if (!stringKeys)
+    {
+        for (Row& row : rows)
+        {
+            if (!parseNumber(row))
+            {
+                std::cerr << options.m_input << ":" << row.m_line << ": key is not a number: " << row.m_key
+                          << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // stable, so that a repeated key is reported at its later line
+    std::stable_sort(rows.begin(), rows.end(), stringKeys ? stringLess : numberLess);
+    for (size_t i = 1; i < rows.size(); ++i)
+    {
+        const Row& prev = rows[i - 1];
+        const Row& row = rows[i];
+        const bool same = stringKeys ? !stringLess(prev, row) : !numberLess(prev, row);
+        if (same)
+        {
+            std::cerr << options.m_input << ":" << row.m_line << ": key " << row.m_key << " is repeated from line "
+                      << prev.m_line << std::endl;
+            return 1;
+        }
+    }
+
+    return writeOutput(options, rows, stringKeys, stringVals) ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#!/bin/sh
+#
+#  test_smgen.sh
+#  StaticMap
+#
+# builds smgen, checks that it writes test_smgen_table.hpp and .cpp from
+# test_smgen.csv as they are checked in (the test app compiles and uses
+# them), and that it fails on a repeated key.  run from the top of the repo:
+#
+# sh tools/test_smgen.sh
+#
+
+set -e
+
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+${CXX:-c++} -std=c++14 -O2 tools/smgen.cpp -o "$out/smgen"
+
+"$out/smgen" --type HttpStatusMap --map g_httpStatus --key int --val "const char*" --skip-header \
+    tools/test_smgen.csv "$out/test_smgen_table"
+diff test_smgen_table.hpp "$out/test_smgen_table.hpp"
+diff test_smgen_table.cpp "$out/test_smgen_table.cpp"
+
+printf '1,one\n2,two\n1,uno\n' > "$out/repeated.csv"
+if "$out/smgen" --type M --map g_m --key int --val "const char*" "$out/repeated.csv" "$out/repeated" 2> "$out/err.txt"
+then
+    echo "smgen took a repeated key"
+    exit 1
+fi
+grep -q "repeated.csv:3: key 1 is repeated from line 1" "$out/err.txt"
+
+echo "smgen ok"